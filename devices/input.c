@@ -38,6 +38,32 @@ input_getc (void) {
 	return key;
 }
 
+/* Like input_getc(), but returns -1 without a key once *STOP is
+   true.  Whoever sets *STOP must then call input_interrupt(). */
+int
+input_getc_until (const bool *stop) {
+	enum intr_level old_level;
+	int key;
+
+	old_level = intr_disable ();
+	key = intq_getc_until (&buffer, stop);
+	serial_notify ();
+	intr_set_level (old_level);
+
+	return key;
+}
+
+/* Wakes the thread, if any, waiting in input_getc_until() to
+   check its stop flag. */
+void
+input_interrupt (void) {
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	intq_interrupt (&buffer);
+	intr_set_level (old_level);
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
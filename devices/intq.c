@@ -2,15 +2,28 @@
 #include <debug.h>
 #include "threads/thread.h"
 
-static int next (int pos);
+static int next (const struct intq *q, int pos);
 static void wait (struct intq *q, struct thread **waiter);
 static void signal (struct intq *q, struct thread **waiter);
 
-/* Initializes interrupt queue Q. */
+/* Initializes interrupt queue Q with its own INTQ_BUFSIZE-byte
+   buffer. */
 void
 intq_init (struct intq *q) {
+	intq_init_buffer (q, q->inline_buf, INTQ_BUFSIZE);
+}
+
+/* Initializes interrupt queue Q to use the SIZE bytes at BUF,
+   which must outlive Q.  Q holds at most SIZE - 1 bytes. */
+void
+intq_init_buffer (struct intq *q, uint8_t *buf, int size) {
+	ASSERT (buf != NULL);
+	ASSERT (size > 1);
+
 	lock_init (&q->lock);
 	q->not_full = q->not_empty = NULL;
+	q->buf = buf;
+	q->size = size;
 	q->head = q->tail = 0;
 }
 
@@ -25,7 +38,7 @@ intq_empty (const struct intq *q) {
 bool
 intq_full (const struct intq *q) {
 	ASSERT (intr_get_level () == INTR_OFF);
-	return next (q->head) == q->tail;
+	return next (q, q->head) == q->tail;
 }
 
 /* Removes a byte from Q and returns it.
@@ -45,11 +58,45 @@ intq_getc (struct intq *q) {
 	}
 
 	byte = q->buf[q->tail];
-	q->tail = next (q->tail);
+	q->tail = next (q, q->tail);
 	signal (q, &q->not_full);
 	return byte;
 }
 
+/* Like intq_getc(), but gives up and returns -1 instead of
+   sleeping once *STOP is true.  A thread that sets *STOP must
+   then call intq_interrupt() to wake a waiter that missed it. */
+int
+intq_getc_until (struct intq *q, const bool *stop) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	while (intq_empty (q)) {
+		ASSERT (!intr_context ());
+		lock_acquire (&q->lock);
+		if (*stop) {
+			lock_release (&q->lock);
+			return -1;
+		}
+		/* A byte may have come in while we waited for the lock. */
+		if (intq_empty (q))
+			wait (q, &q->not_empty);
+		lock_release (&q->lock);
+	}
+	return intq_getc (q);
+}
+
+/* Wakes the thread, if any, waiting for Q to become nonempty,
+   even though it still is empty.  intq_getc() just waits again;
+   intq_getc_until() checks its stop flag first. */
+void
+intq_interrupt (struct intq *q) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (q->not_empty != NULL) {
+		thread_unblock (q->not_empty);
+		q->not_empty = NULL;
+	}
+}
+
 /* Adds BYTE to the end of Q.
    Q must not be full if called from an interrupt handler.
    Otherwise, if Q is full, first sleeps until a byte is
@@ -65,14 +112,14 @@ intq_putc (struct intq *q, uint8_t byte) {
 	}
 
 	q->buf[q->head] = byte;
-	q->head = next (q->head);
+	q->head = next (q, q->head);
 	signal (q, &q->not_empty);
 }
 
-/* Returns the position after POS within an intq. */
+/* Returns the position after POS within Q. */
 static int
-next (int pos) {
-	return (pos + 1) % INTQ_BUFSIZE;
+next (const struct intq *q, int pos) {
+	return (pos + 1) % q->size;
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
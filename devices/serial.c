@@ -51,7 +51,10 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
+/* Data to be transmitted.  Large enough that console writers
+   rarely have to wait for the UART. */
+#define TXQ_SIZE 4096
+static uint8_t txq_buf[TXQ_SIZE];
 static struct intq txq;
 
 static void set_serial (int bps);
@@ -70,7 +73,7 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	intq_init_buffer (&txq, txq_buf, TXQ_SIZE);
 	mode = POLL;
 }
 
@@ -95,27 +98,43 @@ serial_init_queue (void) {
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
+	serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port.  In queued
+   mode, interrupts are disabled once for the whole buffer, and
+   the caller sleeps only while the transmit queue is full. */
+void
+serial_putbuf (const uint8_t *buffer, size_t n) {
 	enum intr_level old_level = intr_disable ();
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
-		   use dumb polling to transmit a byte. */
+		   use dumb polling to transmit. */
 		if (mode == UNINIT)
 			init_poll ();
-		putc_poll (byte);
+		while (n-- > 0)
+			putc_poll (*buffer++);
 	} else {
-		/* Otherwise, queue a byte and update the interrupt enable
-		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
+		while (n-- > 0) {
+			if (intq_full (&txq)) {
+				if (old_level == INTR_OFF) {
+					/* Interrupts are off and the transmit queue is
+					   full.  If we wanted to wait for the queue to
+					   empty, we'd have to reenable interrupts.
+					   That's impolite, so we'll send a character
+					   via polling instead. */
+					putc_poll (intq_getc (&txq));
+				} else {
+					/* intq_putc() is about to sleep; make sure the
+					   transmit interrupt will wake us up. */
+					write_ier ();
+				}
+			}
+			intq_putc (&txq, *buffer++);
 		}
 
-		intq_putc (&txq, byte);
+		/* Update the interrupt enable register. */
 		write_ier ();
 	}
 
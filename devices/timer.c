@@ -7,6 +7,11 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "userprog/vdso.h"
+#endif
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -28,24 +33,65 @@ int64_t MIN_alarm_time = INT64_MAX;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Nanoseconds per timer tick and per second. */
+#define NS_PER_TICK (1000000000 / TIMER_FREQ)
+#define NS_PER_SEC 1000000000ULL
+
+/* Ticks over which the TSC is calibrated against the PIT. */
+#define TSC_CAL_TICKS 10
+
+/* Sleeps spin, instead of yielding, for this many nanoseconds
+   at most. */
+#define SPIN_NS 20000
+
+/* TSC frequency in Hz, or 0 before timer_calibrate(), and the
+   TSC value and time in nanoseconds at calibration. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static uint64_t tsc_base_ns;
+
+/* If true, the idle thread stops the periodic tick while it
+   waits, programming the PIT to interrupt only when the next
+   sleeper is due.  Controlled by kernel command-line option
+   "-tickless". */
+bool timer_tickless;
+
+/* 8254 input frequency, and the PIT count of one timer tick. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Most ticks one one-shot countdown can cover, since the PIT
+   count is 16 bits wide. */
+#define MAX_SKIP (0xffff / PIT_COUNT)
+
+/* Ticks covered by the armed one-shot countdown, or 0 if the
+   PIT is in periodic mode. */
+static int64_t oneshot_ticks;
+
+/* PIT counts from arming the one-shot to its first tick
+   boundary, and in total. */
+static unsigned oneshot_first;
+static unsigned oneshot_count;
+
+/* Number of ticks accounted without a timer interrupt. */
+static int64_t skipped_ticks;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void tsc_calibrate (void);
+static void pit_periodic (void);
+static void pit_oneshot (unsigned count);
+static bool pit_read (unsigned *count);
+static void skip_ticks (int64_t n);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
-
+	pit_periodic ();
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -72,6 +118,9 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	tsc_calibrate ();
+	printf ("TSC runs at %'"PRIu64" Hz.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -91,6 +140,24 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted.  The
+   result is monotonic and, once timer_calibrate() has run, as
+   fine as the CPU's time-stamp counter; before that, it only
+   advances once per timer tick. */
+uint64_t
+timer_now_ns (void) {
+	uint64_t cycles;
+
+	if (tsc_hz == 0)
+		return (uint64_t) timer_ticks () * NS_PER_TICK;
+
+	/* Split the conversion so that CYCLES * NS_PER_SEC cannot
+	   overflow. */
+	cycles = rdtsc () - tsc_base;
+	return tsc_base_ns + cycles / tsc_hz * NS_PER_SEC
+		+ cycles % tsc_hz * NS_PER_SEC / tsc_hz;
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void
 timer_sleep (int64_t ticks) {
@@ -105,6 +172,41 @@ timer_sleep (int64_t ticks) {
 	thread_sleep(timer_ticks()+ticks);
 }
 
+/* Suspends execution for at least NS nanoseconds.  Whole timer
+   ticks are slept with timer_sleep(), the rest of the delay is
+   spent yielding to other threads, and only the last SPIN_NS or
+   so is spun on the TSC. */
+void
+timer_sleep_ns (int64_t ns) {
+	uint64_t deadline, now;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	if (ns <= 0)
+		return;
+	now = timer_now_ns ();
+	deadline = now + ns;
+
+	/* timer_sleep(N) returns after somewhere between N - 1 and N
+	   ticks, so this never oversleeps. */
+	while (deadline - now >= NS_PER_TICK) {
+		timer_sleep ((deadline - now) / NS_PER_TICK);
+		now = timer_now_ns ();
+		if (now >= deadline)
+			return;
+	}
+
+	while (deadline - now > SPIN_NS) {
+		thread_yield ();
+		now = timer_now_ns ();
+		if (now >= deadline)
+			return;
+	}
+
+	while (timer_now_ns () < deadline)
+		barrier ();
+}
+
 /* Suspends execution for approximately MS milliseconds. */
 void
 timer_msleep (int64_t ms) {
@@ -126,14 +228,105 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %"PRId64" ticks", timer_ticks ());
+	if (timer_tickless)
+		printf (", %"PRId64" skipped", skipped_ticks);
+	printf ("\n");
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, replaces the periodic tick by a
+   one-shot countdown that ends when the earliest sleeper or
+   delayed work item is due, or after MAX_SKIP ticks, whichever
+   is sooner. */
+void
+timer_idle_enter (void) {
+	int64_t skip;
+	unsigned count;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || oneshot_ticks != 0)
+		return;
+
+	skip = MIN_alarm_time;
+	if (skip > work_pool_deadline ())
+		skip = work_pool_deadline ();
+	skip -= ticks;
+	if (skip > MAX_SKIP)
+		skip = MAX_SKIP;
+	if (skip < 2)
+		return;
+
+	/* Keep the phase of the periodic tick: the countdown first
+	   runs out the current tick, then SKIP - 1 whole ones. */
+	pit_read (&count);
+	if (count == 0 || count > PIT_COUNT)
+		count = PIT_COUNT;
+	oneshot_first = count;
+	oneshot_count = count + (skip - 1) * PIT_COUNT;
+	oneshot_ticks = skip;
+	pit_oneshot (oneshot_count);
+}
+
+/* Called by the idle thread, with interrupts off, when it wakes
+   up from a halt.  If some other interrupt ended the halt before
+   the one-shot countdown ran out, accounts for the ticks that
+   have passed and arms a one-shot for the rest of the current
+   tick, so that the periodic tick resumes in phase. */
+void
+timer_idle_exit (void) {
+	unsigned count, elapsed;
+	int64_t passed;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* If the countdown has run out, its interrupt is pending and
+	   will do the accounting. */
+	if (oneshot_ticks == 0 || pit_read (&count))
+		return;
+
+	elapsed = count <= oneshot_count ? oneshot_count - count : 0;
+	if (elapsed < oneshot_first) {
+		if (oneshot_ticks == 1)
+			return;
+		passed = 0;
+		count = oneshot_first - elapsed;
+	} else {
+		elapsed -= oneshot_first;
+		passed = 1 + elapsed / PIT_COUNT;
+		count = PIT_COUNT - elapsed % PIT_COUNT;
+	}
+
+	skip_ticks (passed);
+	oneshot_first = oneshot_count = count;
+	oneshot_ticks = 1;
+	pit_oneshot (count);
+
+	if (MIN_alarm_time <= ticks)
+		thread_awake (ticks);
+	work_pool_timer (ticks);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	/* A one-shot countdown that has run out stands for the ticks
+	   it covered.  If it is still running, this is a periodic tick
+	   that was already pending when it was armed. */
+	if (oneshot_ticks != 0 && pit_read (NULL)) {
+		int64_t n = oneshot_ticks;
+
+		oneshot_ticks = 0;
+		pit_periodic ();
+		skip_ticks (n - 1);
+	}
+
 	ticks++;
 	thread_tick ();
+#ifdef USERPROG
+	vdso_update (thread_current (), ticks);
+#endif
 
 	if (thread_mlfqs) {
 		mlfqs_increment();
@@ -149,6 +342,64 @@ timer_interrupt (struct intr_frame *args UNUSED) {
 	if (MIN_alarm_time <= ticks) {
 		thread_awake(ticks);
 	}
+	work_pool_timer (ticks);
+}
+
+/* Programs PIT counter 0 to interrupt TIMER_FREQ times per
+   second. */
+static void
+pit_periodic (void) {
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, PIT_COUNT & 0xff);
+	outb (0x40, PIT_COUNT >> 8);
+}
+
+/* Programs PIT counter 0 to interrupt once, after COUNT input
+   clocks. */
+static void
+pit_oneshot (unsigned count) {
+	ASSERT (count > 0 && count <= 0xffff);
+
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Latches PIT counter 0 and returns the state of its output,
+   which in mode 0 goes high once the countdown has run out.
+   Stores the current count into *COUNT if COUNT is non-null. */
+static bool
+pit_read (unsigned *count) {
+	uint8_t status, lsb, msb;
+
+	outb (0x43, 0xc2);    /* Read-back: latch count and status of counter 0. */
+	status = inb (0x40);
+	lsb = inb (0x40);
+	msb = inb (0x40);
+	if (count != NULL)
+		*count = lsb | (msb << 8);
+	return (status & 0x80) != 0;
+}
+
+/* Accounts for N ticks that passed in the idle thread without a
+   timer interrupt. */
+static void
+skip_ticks (int64_t n) {
+	if (n <= 0)
+		return;
+
+	thread_idle_ticks (n);
+	skipped_ticks += n;
+	while (n-- > 0) {
+		ticks++;
+		if (thread_mlfqs && ticks % 100 == 0) {
+			mlfqs_load_avg ();
+			mlfqs_recalc ();
+		}
+	}
+#ifdef USERPROG
+	vdso_update (thread_current (), ticks);
+#endif
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -185,6 +436,14 @@ busy_wait (int64_t loops) {
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
 real_time_sleep (int64_t num, int32_t denom) {
+	ASSERT (intr_get_level () == INTR_ON);
+	ASSERT (NS_PER_SEC % denom == 0);
+
+	if (tsc_hz != 0) {
+		timer_sleep_ns (num * (int64_t) (NS_PER_SEC / denom));
+		return;
+	}
+
 	/* Convert NUM/DENOM seconds into timer ticks, rounding down.
 
 	   (NUM / DENOM) s
@@ -193,7 +452,6 @@ real_time_sleep (int64_t num, int32_t denom) {
 	   */
 	int64_t ticks = num * TIMER_FREQ / denom;
 
-	ASSERT (intr_get_level () == INTR_ON);
 	if (ticks > 0) {
 		/* We're waiting for at least one full timer tick.  Use
 		   timer_sleep() because it will yield the CPU to other
@@ -207,3 +465,32 @@ real_time_sleep (int64_t num, int32_t denom) {
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* Measures the TSC frequency over TSC_CAL_TICKS timer ticks.
+   Assumes an invariant TSC, one that ticks at a constant rate
+   regardless of CPU frequency and sleep states, as on every
+   CPU that QEMU and Bochs emulate. */
+static void
+tsc_calibrate (void) {
+	int64_t start;
+	uint64_t t0, t1;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	/* Start right at a tick boundary. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	t0 = rdtsc ();
+
+	while (ticks - start < TSC_CAL_TICKS)
+		barrier ();
+	t1 = rdtsc ();
+
+	tsc_base = t0;
+	tsc_base_ns = (uint64_t) start * NS_PER_TICK;
+	tsc_hz = (t1 - t0) * TIMER_FREQ / TSC_CAL_TICKS;
+	if (tsc_hz == 0)
+		tsc_hz = 1;
+}
@@ -5,6 +5,7 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -109,10 +110,12 @@ dir_lookup (const struct dir *dir, const char *name,
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	rwlock_acquire_read (inode_get_rwlock (dir->inode));
 	if (lookup (dir, name, &e, NULL))
 		*inode = inode_open (e.inode_sector);
 	else
 		*inode = NULL;
+	rwlock_release_read (inode_get_rwlock (dir->inode));
 
 	return *inode != NULL;
 }
@@ -136,6 +139,8 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
+	rwlock_acquire_write (inode_get_rwlock (dir->inode));
+
 	/* Check that NAME is not in use. */
 	if (lookup (dir, name, NULL, NULL))
 		goto done;
@@ -159,6 +164,7 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
 done:
+	rwlock_release_write (inode_get_rwlock (dir->inode));
 	return success;
 }
 
@@ -175,6 +181,8 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	rwlock_acquire_write (inode_get_rwlock (dir->inode));
+
 	/* Find directory entry. */
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
@@ -194,6 +202,7 @@ dir_remove (struct dir *dir, const char *name) {
 	success = true;
 
 done:
+	rwlock_release_write (inode_get_rwlock (dir->inode));
 	inode_close (inode);
 	return success;
 }
@@ -204,13 +213,17 @@ done:
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
+	bool found = false;
 
+	rwlock_acquire_read (inode_get_rwlock (dir->inode));
 	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	rwlock_release_read (inode_get_rwlock (dir->inode));
+	return found;
 }
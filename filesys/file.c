@@ -1,13 +1,18 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
+#include "filesys/pipe.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 
 /* An open file. */
 struct file {
-	struct inode *inode;        /* File's inode. */
+	struct inode *inode;        /* File's inode, null for a pipe end. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	int ref_cnt;                /* Number of descriptors sharing it. */
+	struct pipe *pipe;          /* Pipe this is an end of, if any. */
+	bool pipe_writer;           /* Write end (true) or read end of PIPE. */
 };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -20,6 +25,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -39,6 +45,10 @@ file_reopen (struct file *file) {
  * same inode as FILE. Returns a null pointer if unsuccessful. */
 struct file *
 file_duplicate (struct file *file) {
+	if (file->pipe != NULL)
+		return file_open_pipe (pipe_reopen (file->pipe, file->pipe_writer),
+				file->pipe_writer);
+
 	struct file *nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
@@ -48,12 +58,67 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
-/* Closes FILE. */
+/* Opens the read end (WRITER false) or write end (WRITER true) of
+ * PIPE as a file, taking ownership of that end.  Returns a null
+ * pointer, closing the end, if PIPE is null or allocation fails. */
+struct file *
+file_open_pipe (struct pipe *pipe, bool writer) {
+	struct file *file = calloc (1, sizeof *file);
+	if (pipe != NULL && file != NULL) {
+		file->pipe = pipe;
+		file->pipe_writer = writer;
+		file->ref_cnt = 1;
+		return file;
+	} else {
+		if (pipe != NULL)
+			pipe_close (pipe, writer);
+		free (file);
+		return NULL;
+	}
+}
+
+/* Returns the pipe FILE is an end of, or a null pointer for an
+ * ordinary file.  If WRITER is nonnull, stores whether FILE is
+ * the write end there. */
+struct pipe *
+file_get_pipe (struct file *file, bool *writer) {
+	ASSERT (file != NULL);
+	if (writer != NULL)
+		*writer = file->pipe_writer;
+	return file->pipe;
+}
+
+/* Adds a reference to FILE for one more file descriptor, as
+ * dup2() does, and returns FILE.  Each reference is dropped with
+ * its own file_close().  The threads of a process share their
+ * descriptors, so the count changes with interrupts off. */
+struct file *
+file_dup (struct file *file) {
+	enum intr_level old_level;
+
+	ASSERT (file != NULL);
+	old_level = intr_disable ();
+	file->ref_cnt++;
+	intr_set_level (old_level);
+	return file;
+}
+
+/* Closes FILE once its last reference is dropped. */
 void
 file_close (struct file *file) {
 	if (file != NULL) {
-		file_allow_write (file);
-		inode_close (file->inode);
+		enum intr_level old_level = intr_disable ();
+		int ref_cnt = --file->ref_cnt;
+
+		intr_set_level (old_level);
+		if (ref_cnt > 0)
+			return;
+		if (file->pipe != NULL) {
+			pipe_close (file->pipe, file->pipe_writer);
+		} else {
+			file_allow_write (file);
+			inode_close (file->inode);
+		}
 		free (file);
 	}
 }
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -33,6 +34,8 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rwlock;               /* For the inode's user, such as a
+	                                       directory over it. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -50,13 +53,37 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.  Searching it takes a read
+ * lock, adding or removing an inode a write lock. */
 static struct list open_inodes;
+static struct rwlock open_inodes_lock;
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	rwlock_init (&open_inodes_lock);
+}
+
+/* Returns the inode in the open inode list for SECTOR, with its
+ * open count incremented, or a null pointer if there is none.
+ * The open inode list must be locked.  Readers may call this
+ * concurrently, so the count goes up atomically; inode_close()
+ * takes the write lock, so it cannot drop the count to zero
+ * meanwhile. */
+static struct inode *
+find_open_inode (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector) {
+			__atomic_add_fetch (&inode->open_cnt, 1, __ATOMIC_SEQ_CST);
+			return inode;
+		}
+	}
+	return NULL;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,23 +128,26 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
 	struct inode *inode;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	rwlock_acquire_read (&open_inodes_lock);
+	inode = find_open_inode (sector);
+	rwlock_release_read (&open_inodes_lock);
+	if (inode != NULL)
+		return inode;
+
+	/* Check again under the write lock, in case another thread
+	 * opened it in the meantime. */
+	rwlock_acquire_write (&open_inodes_lock);
+	inode = find_open_inode (sector);
+	if (inode != NULL)
+		goto done;
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
 	if (inode == NULL)
-		return NULL;
+		goto done;
 
 	/* Initialize. */
 	list_push_front (&open_inodes, &inode->elem);
@@ -125,7 +155,11 @@ inode_open (disk_sector_t sector) {
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->rwlock);
 	disk_read (filesys_disk, inode->sector, &inode->data);
+
+done:
+	rwlock_release_write (&open_inodes_lock);
 	return inode;
 }
 
@@ -133,10 +167,18 @@ inode_open (disk_sector_t sector) {
 struct inode *
 inode_reopen (struct inode *inode) {
 	if (inode != NULL)
-		inode->open_cnt++;
+		__atomic_add_fetch (&inode->open_cnt, 1, __ATOMIC_SEQ_CST);
 	return inode;
 }
 
+/* Returns INODE's reader-writer lock, which inode.c itself does
+ * not use.  It lets the users of an inode share one lock per
+ * inode however many times it is open. */
+struct rwlock *
+inode_get_rwlock (struct inode *inode) {
+	return &inode->rwlock;
+}
+
 /* Returns INODE's inode number. */
 disk_sector_t
 inode_get_inumber (const struct inode *inode) {
@@ -153,9 +195,11 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
+	rwlock_acquire_write (&open_inodes_lock);
+	if (__atomic_sub_fetch (&inode->open_cnt, 1, __ATOMIC_SEQ_CST) == 0) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+		rwlock_release_write (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -165,7 +209,8 @@ inode_close (struct inode *inode) {
 		}
 
 		free (inode); 
-	}
+	} else
+		rwlock_release_write (&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
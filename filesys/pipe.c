@@ -0,0 +1,256 @@
+/* pipe.c: Kernel pipes for inter-process byte streams.
+ *
+ * A pipe buffers data in a small ring of page-sized slots.  The
+ * writer appends to the newest slot until it fills, except that a
+ * write of a whole page-aligned page always starts a slot of its
+ * own.  A slot holding exactly one full page can then be handed to
+ * a reader reading into a page-aligned buffer by swapping it with
+ * the reader's frame, so page-sized transfers cost one copy (into
+ * the pipe) instead of two. */
+
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* Number of page slots buffered by each pipe. */
+#define PIPE_SLOTS 4
+
+/* One page of buffered data. */
+struct pipe_slot {
+	uint8_t *page;              /* Buffer page (user pool), or null. */
+	size_t start;               /* Offset of first unread byte. */
+	size_t end;                 /* Offset just past last written byte. */
+};
+
+/* A pipe. */
+struct pipe {
+	struct lock lock;           /* Protects all members. */
+	struct condition readable;  /* Data arrived or writers went away. */
+	struct condition writable;  /* Slot freed or readers went away. */
+	struct pipe_slot slots[PIPE_SLOTS];
+	size_t head;                /* Slot being read. */
+	size_t used;                /* Number of slots holding data. */
+	int readers;                /* Open read ends. */
+	int writers;                /* Open write ends. */
+};
+
+static struct pipe_slot *pipe_tail (struct pipe *);
+static struct pipe_slot *pipe_push_slot (struct pipe *);
+static bool pipe_give_page (struct pipe_slot *, void *upage);
+static bool pipe_exiting (void);
+
+/* Creates a pipe with one read end and one write end open and
+ * stores it in *PIPE.  Returns false if memory is not available. */
+bool
+pipe_create (struct pipe **pipe) {
+	struct pipe *p = calloc (1, sizeof *p);
+	if (p == NULL)
+		return false;
+
+	lock_init (&p->lock);
+	cond_init (&p->readable);
+	cond_init (&p->writable);
+	p->readers = 1;
+	p->writers = 1;
+	*pipe = p;
+	return true;
+}
+
+/* Opens one more read end (WRITER false) or write end (WRITER
+ * true) of PIPE, and returns PIPE. */
+struct pipe *
+pipe_reopen (struct pipe *pipe, bool writer) {
+	lock_acquire (&pipe->lock);
+	if (writer)
+		pipe->writers++;
+	else
+		pipe->readers++;
+	lock_release (&pipe->lock);
+	return pipe;
+}
+
+/* Closes one read end or write end of PIPE.  Wakes up the other
+ * side when the last end of a kind goes away, and frees PIPE with
+ * its buffered data once no ends are left. */
+void
+pipe_close (struct pipe *pipe, bool writer) {
+	bool dead;
+
+	lock_acquire (&pipe->lock);
+	if (writer) {
+		if (--pipe->writers == 0)
+			cond_broadcast (&pipe->readable, &pipe->lock);
+	} else {
+		if (--pipe->readers == 0)
+			cond_broadcast (&pipe->writable, &pipe->lock);
+	}
+	dead = pipe->readers == 0 && pipe->writers == 0;
+	lock_release (&pipe->lock);
+
+	if (dead) {
+		for (int i = 0; i < PIPE_SLOTS; i++)
+			palloc_free_page (pipe->slots[i].page);
+		free (pipe);
+	}
+}
+
+/* Wakes every thread waiting to read from or write to PIPE, so
+ * that those whose process is exiting can give up. */
+void
+pipe_interrupt (struct pipe *pipe) {
+	lock_acquire (&pipe->lock);
+	cond_broadcast (&pipe->readable, &pipe->lock);
+	cond_broadcast (&pipe->writable, &pipe->lock);
+	lock_release (&pipe->lock);
+}
+
+/* Reads up to SIZE bytes from PIPE into BUFFER.  Blocks until at
+ * least one byte is available, then returns whatever is buffered
+ * up to SIZE.  Returns 0 at end of stream, that is, when the pipe
+ * is empty and every write end is closed, or -1 if the process
+ * starts exiting while we wait. */
+int
+pipe_read (struct pipe *pipe, void *buffer, size_t size) {
+	uint8_t *dst = buffer;
+	size_t bytes_read = 0;
+
+	lock_acquire (&pipe->lock);
+	while (pipe->used == 0 && pipe->writers > 0) {
+		if (pipe_exiting ()) {
+			lock_release (&pipe->lock);
+			return -1;
+		}
+		cond_wait (&pipe->readable, &pipe->lock);
+	}
+
+	while (bytes_read < size && pipe->used > 0) {
+		struct pipe_slot *slot = &pipe->slots[pipe->head];
+		size_t left = size - bytes_read;
+		size_t n;
+
+		if (slot->start == 0 && slot->end == PGSIZE
+				&& pg_ofs (dst) == 0 && left >= PGSIZE
+				&& pipe_give_page (slot, dst))
+			n = PGSIZE;
+		else {
+			n = slot->end - slot->start < left ? slot->end - slot->start : left;
+			memcpy (dst, slot->page + slot->start, n);
+		}
+		slot->start += n;
+		dst += n;
+		bytes_read += n;
+
+		if (slot->start == slot->end) {
+			pipe->head = (pipe->head + 1) % PIPE_SLOTS;
+			pipe->used--;
+		}
+	}
+	cond_broadcast (&pipe->writable, &pipe->lock);
+	lock_release (&pipe->lock);
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER to PIPE, blocking while the pipe
+ * is full.  Returns the number of bytes written, which is short
+ * only if every read end closes, a buffer page cannot be
+ * allocated, or the process starts exiting, or -1 if nothing
+ * could be written. */
+int
+pipe_write (struct pipe *pipe, const void *buffer, size_t size) {
+	const uint8_t *src = buffer;
+	size_t written = 0;
+
+	lock_acquire (&pipe->lock);
+	while (written < size && pipe->readers > 0) {
+		size_t left = size - written;
+		bool whole_page = pg_ofs (src) == 0 && left >= PGSIZE;
+		struct pipe_slot *slot = pipe_tail (pipe);
+		size_t n;
+
+		/* Page-aligned whole pages get a slot of their own so that
+		   the reader can take the page over without copying. */
+		if (slot == NULL || slot->end == PGSIZE || (whole_page && slot->end != 0)) {
+			if (pipe->used == PIPE_SLOTS) {
+				if (pipe_exiting ())
+					break;
+				cond_wait (&pipe->writable, &pipe->lock);
+				continue;
+			}
+			slot = pipe_push_slot (pipe);
+			if (slot == NULL)
+				break;
+		}
+
+		n = PGSIZE - slot->end < left ? PGSIZE - slot->end : left;
+		memcpy (slot->page + slot->end, src, n);
+		slot->end += n;
+		src += n;
+		written += n;
+		cond_signal (&pipe->readable, &pipe->lock);
+	}
+	lock_release (&pipe->lock);
+	return written > 0 || size == 0 ? (int) written : -1;
+}
+
+/* Returns the slot the writer appends to, or a null pointer if
+ * PIPE is empty. */
+static struct pipe_slot *
+pipe_tail (struct pipe *pipe) {
+	if (pipe->used == 0)
+		return NULL;
+	return &pipe->slots[(pipe->head + pipe->used - 1) % PIPE_SLOTS];
+}
+
+/* Claims an empty slot at the tail of PIPE, allocating its page
+ * on first use.  PIPE must not be full.  Returns a null pointer if
+ * no page is available. */
+static struct pipe_slot *
+pipe_push_slot (struct pipe *pipe) {
+	struct pipe_slot *slot;
+
+	ASSERT (pipe->used < PIPE_SLOTS);
+	slot = &pipe->slots[(pipe->head + pipe->used) % PIPE_SLOTS];
+	if (slot->page == NULL) {
+		slot->page = palloc_get_page (PAL_USER);
+		if (slot->page == NULL)
+			return NULL;
+	}
+	slot->start = slot->end = 0;
+	pipe->used++;
+	return slot;
+}
+
+/* Returns true if the running thread's process is exiting, in
+ * which case it must not go to sleep on a pipe.  The exiting
+ * thread sets the flag before calling pipe_interrupt(), and we
+ * check it under the pipe's lock, so no wakeup is missed. */
+static bool
+pipe_exiting (void) {
+	return thread_current ()->leader->exiting;
+}
+
+/* Tries to move the full page in SLOT into the current process at
+ * page-aligned user address UPAGE by swapping frames, leaving the
+ * process's old frame page in SLOT for reuse.  Returns false if
+ * UPAGE is not backed by a resident, writable anonymous page. */
+static bool
+pipe_give_page (struct pipe_slot *slot, void *upage) {
+#ifdef VM
+	void *old = vm_exchange_frame (upage, slot->page);
+	if (old == NULL)
+		return false;
+	slot->page = old;
+	return true;
+#else
+	return false;
+#endif
+}
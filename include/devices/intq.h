@@ -17,7 +17,7 @@
    protect kernel threads from one another, not from interrupt
    handlers. */
 
-/* Queue buffer size, in bytes. */
+/* Default queue buffer size, in bytes. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
@@ -28,15 +28,20 @@ struct intq {
 	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
 
 	/* Queue. */
-	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
+	uint8_t *buf;               /* Buffer. */
+	int size;                   /* Buffer size, in bytes. */
 	int head;                   /* New data is written here. */
 	int tail;                   /* Old data is read here. */
+	uint8_t inline_buf[INTQ_BUFSIZE]; /* Default buffer. */
 };
 
 void intq_init (struct intq *);
+void intq_init_buffer (struct intq *, uint8_t *buf, int size);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
+int intq_getc_until (struct intq *, const bool *stop);
+void intq_interrupt (struct intq *);
 void intq_putc (struct intq *, uint8_t);
 
 #endif /* devices/intq.h */
@@ -6,11 +6,13 @@
 #include "devices/disk.h"
 
 struct bitmap;
+struct rwlock;
 
 void inode_init (void);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
 struct inode *inode_reopen (struct inode *);
+struct rwlock *inode_get_rwlock (struct inode *);
 disk_sector_t inode_get_inumber (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
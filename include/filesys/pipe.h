@@ -0,0 +1,16 @@
+#ifndef FILESYS_PIPE_H
+#define FILESYS_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct pipe;
+
+bool pipe_create (struct pipe **pipe);
+struct pipe *pipe_reopen (struct pipe *, bool writer);
+void pipe_close (struct pipe *, bool writer);
+int pipe_read (struct pipe *, void *buffer, size_t size);
+int pipe_write (struct pipe *, const void *buffer, size_t size);
+void pipe_interrupt (struct pipe *);
+
+#endif /* filesys/pipe.h */
@@ -0,0 +1,19 @@
+#ifndef __LIB_FUTEX_H
+#define __LIB_FUTEX_H
+
+/* Operations for the futex() system call.  A futex is any
+   aligned int in user memory.  Programs handle the uncontended
+   case with atomic instructions on the int alone and only call
+   into the kernel to sleep on it or to wake its sleepers.
+   Shared by the kernel and user programs. */
+
+/* futex (addr, FUTEX_WAIT, val): if *addr still equals val,
+   sleep until woken; returns 0 once woken, or -1 at once if
+   *addr differs. */
+#define FUTEX_WAIT 0
+
+/* futex (addr, FUTEX_WAKE, n): wakes up to n threads sleeping
+   on addr and returns how many were woken. */
+#define FUTEX_WAKE 1
+
+#endif /* lib/futex.h */
@@ -0,0 +1,17 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+#include <stddef.h>
+
+/* One buffer of a scatter/gather request (readv, writev).
+   Shared by the kernel and user programs, so the layout must
+   stay the same on both sides of the system call. */
+struct iovec {
+	void *iov_base;             /* Start of the buffer. */
+	size_t iov_len;             /* Length of the buffer in bytes. */
+};
+
+/* Maximum number of buffers in a single readv/writev call. */
+#define IOV_MAX 64
+
+#endif /* lib/iovec.h */
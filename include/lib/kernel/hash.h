@@ -18,7 +18,14 @@
  * conversion from a struct hash_elem back to a structure object
  * that contains it.  This is the same technique used in the
  * linked list implementation.  Refer to lib/kernel/list.h for a
- * detailed explanation. */
+ * detailed explanation.
+ *
+ * Resizing is incremental.  When the bucket array is replaced,
+ * the old one is kept alongside the new one, and each insertion
+ * or deletion afterward moves the elements of a few old buckets
+ * into the new array, until the old array is empty and freed.
+ * Searches look in both arrays meanwhile, so no single
+ * operation has to relink every element in the table. */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -59,6 +66,9 @@ struct hash {
 	size_t elem_cnt;            /* Number of elements in table. */
 	size_t bucket_cnt;          /* Number of buckets, a power of 2. */
 	struct list *buckets;       /* Array of `bucket_cnt' lists. */
+	size_t old_bucket_cnt;      /* Number of buckets in `old_buckets'. */
+	struct list *old_buckets;   /* Array being drained, or null. */
+	size_t migrate_idx;         /* Next bucket of `old_buckets' to drain. */
 	hash_hash_func *hash;       /* Hash function. */
 	hash_less_func *less;       /* Comparison function. */
 	void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -0,0 +1,119 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+ *
+ * A drop-in alternative to the chained table in hash.h, with the
+ * same interface under an `ohash_' prefix.  Instead of an array of
+ * lists, the table is a single array of slots, each holding an
+ * element pointer and its hash value, searched with linear
+ * probing and kept in Robin Hood order: an element never sits
+ * further from its home slot than the element it displaced, so a
+ * probe can stop as soon as it meets a slot whose occupant is
+ * closer to home than the probe is.  Deletion shifts the rest of
+ * the probe run back by one, so no tombstones are needed.
+ *
+ * A lookup thus reads one contiguous run of slots and touches
+ * exactly one element, the one that matched, instead of walking a
+ * chain of elements scattered over memory.
+ *
+ * Growing the table is incremental.  When the load crosses 7/8, a
+ * table twice as large is allocated and takes all new
+ * insertions, while each later insertion or deletion migrates a
+ * few slots from the old table to the new one.  Searches consult
+ * both tables until the old one is empty and freed, so no single
+ * operation ever moves the whole table.  The table does not
+ * shrink.
+ *
+ * As with struct hash, each structure that can be in an ohash
+ * embeds a struct ohash_elem member, and ohash_entry converts
+ * back from one to the structure.  The table keeps everything it
+ * needs in its own slots, so the member carries no data and
+ * costs nothing to embed. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hash element. */
+struct ohash_elem {
+};
+
+/* Converts pointer to hash element OHASH_ELEM into a pointer to
+ * the structure that OHASH_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the hash element. */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) (OHASH_ELEM)                   \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Computes and returns the hash value for hash element E, given
+ * auxiliary data AUX. */
+typedef uint64_t ohash_hash_func (const struct ohash_elem *e, void *aux);
+
+/* Compares the value of two hash elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool ohash_less_func (const struct ohash_elem *a,
+		const struct ohash_elem *b,
+		void *aux);
+
+/* Performs some operation on hash element E, given auxiliary
+ * data AUX. */
+typedef void ohash_action_func (struct ohash_elem *e, void *aux);
+
+/* One slot of a table. */
+struct ohash_slot {
+	uint64_t hash;              /* Hash value of `elem'. */
+	struct ohash_elem *elem;    /* Element, or null if slot is empty. */
+};
+
+/* An array of slots. */
+struct ohash_table {
+	struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+	size_t slot_cnt;            /* Number of slots, a power of 2, or 0. */
+	size_t elem_cnt;            /* Number of occupied slots. */
+};
+
+/* Hash table. */
+struct ohash {
+	size_t elem_cnt;            /* Number of elements in table. */
+	struct ohash_table cur;     /* Table that receives insertions. */
+	struct ohash_table old;     /* Table being drained into `cur'. */
+	size_t migrate_idx;         /* Next slot of `old' to migrate. */
+	ohash_hash_func *hash;      /* Hash function. */
+	ohash_less_func *less;      /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `hash' and `less'. */
+};
+
+/* A hash table iterator. */
+struct ohash_iterator {
+	struct ohash *hash;         /* The hash table. */
+	struct ohash_table *table;  /* Table being iterated. */
+	size_t idx;                 /* Current slot in `table'. */
+	struct ohash_elem *elem;    /* Current hash element. */
+};
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, ohash_hash_func *, ohash_less_func *,
+		void *aux);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+
+/* Search, insertion, deletion. */
+struct ohash_elem *ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_replace (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct ohash_elem *ohash_next (struct ohash_iterator *);
+struct ohash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -36,6 +36,27 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Positional and scatter/gather I/O. */
+	SYS_PREAD,                  /* Read from a file at a given offset. */
+	SYS_PWRITE,                 /* Write to a file at a given offset. */
+	SYS_READV,                  /* Read into several buffers. */
+	SYS_WRITEV,                 /* Write from several buffers. */
+
+	/* Inter-process communication. */
+	SYS_PIPE,                   /* Create a pipe. */
+
+	/* Batched system calls. */
+	SYS_RING_SETUP,             /* Register a submission ring. */
+	SYS_SUBMIT,                 /* Run queued submissions. */
+
+	/* User-space synchronization. */
+	SYS_FUTEX,                  /* Wait on or wake a futex. */
+
+	/* User threads. */
+	SYS_THREAD_CREATE,          /* Start a thread in this process. */
+	SYS_THREAD_JOIN,            /* Wait for a thread to end. */
+	SYS_THREAD_EXIT,            /* End the calling thread. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,56 @@
+#ifndef __LIB_SYSCALL_RING_H
+#define __LIB_SYSCALL_RING_H
+
+#include <stdint.h>
+
+/* Submission/completion ring for batched system calls.
+
+   A user program fills submission entries and advances sq_tail,
+   then calls ring_submit() once for the whole batch.  The kernel
+   consumes entries from sq_head, runs each one exactly as the
+   matching single system call would, and posts a completion at
+   cq_tail.  The program reaps completions by advancing cq_head.
+
+   Indices run freely and are reduced modulo RING_ENTRIES when
+   used, so head == tail means empty and tail - head ==
+   RING_ENTRIES means full.  Shared by the kernel and user
+   programs, so the layout must stay the same on both sides. */
+
+/* Number of entries in each queue.  Must be a power of 2. */
+#define RING_ENTRIES 64
+
+/* Operations a submission entry may request. */
+enum ring_op {
+	RING_OP_NOP,                /* Do nothing; result is 0. */
+	RING_OP_READ,               /* read (fd, buf, len). */
+	RING_OP_WRITE,              /* write (fd, buf, len). */
+	RING_OP_SEEK,               /* seek (fd, len); result is 0. */
+	RING_OP_CLOSE,              /* close (fd); result is 0. */
+};
+
+/* Submission queue entry. */
+struct ring_sqe {
+	int op;                     /* One of RING_OP_*. */
+	int fd;                     /* File descriptor. */
+	void *buf;                  /* Buffer for read and write. */
+	unsigned len;               /* Length, or position for seek. */
+	uint64_t user_data;         /* Passed back in the completion. */
+};
+
+/* Completion queue entry. */
+struct ring_cqe {
+	uint64_t user_data;         /* From the submission entry. */
+	int res;                    /* Result; -1 on error. */
+};
+
+/* A ring, registered with ring_setup(). */
+struct ring {
+	unsigned sq_head;           /* Advanced by the kernel. */
+	unsigned sq_tail;           /* Advanced by the user. */
+	unsigned cq_head;           /* Advanced by the user. */
+	unsigned cq_tail;           /* Advanced by the kernel. */
+	struct ring_sqe sq[RING_ENTRIES];
+	struct ring_cqe cq[RING_ENTRIES];
+};
+
+#endif /* lib/syscall-ring.h */
@@ -4,11 +4,20 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <iovec.h>
+#include <syscall-ring.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
+/* Function run by a thread started with uthread_create(). */
+typedef void uthread_func (void *aux);
+
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
@@ -38,6 +47,32 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Positional and scatter/gather I/O. */
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+
+/* Inter-process communication. */
+int pipe (int fds[2]);
+
+/* Batched system calls. */
+int ring_setup (struct ring *ring);
+int ring_submit (unsigned to_submit);
+
+/* User-space synchronization. */
+int futex (int *addr, int op, int val);
+
+/* Threads sharing the process's memory and open files. */
+tid_t uthread_create (uthread_func *, void *aux, void *stack);
+int uthread_join (tid_t);
+void uthread_exit (void) NO_RETURN;
+
+/* Read from the vDSO page, without entering the kernel. */
+int64_t vdso_ticks (void);
+int vdso_timer_freq (void);
+pid_t vdso_getpid (void);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
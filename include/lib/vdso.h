@@ -0,0 +1,22 @@
+#ifndef __LIB_VDSO_H
+#define __LIB_VDSO_H
+
+#include <stdint.h>
+
+/* Read-only page the kernel maps into every user process at
+   VDSO_BASE, just below the kernel, so that a program can read
+   the time and its own identity without a system call.  The
+   kernel refreshes it on every timer interrupt and whenever the
+   process is scheduled.  Shared by the kernel and user programs,
+   so the layout must stay the same on both sides. */
+
+/* User virtual address of the page. */
+#define VDSO_BASE 0x7ffffff000
+
+struct vdso_data {
+	int64_t ticks;              /* Timer ticks since boot. */
+	int32_t timer_freq;         /* Timer ticks per second. */
+	int32_t tid;                /* Thread id of the process. */
+};
+
+#endif /* lib/vdso.h */
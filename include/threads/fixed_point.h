@@ -0,0 +1,71 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point arithmetic for the advanced scheduler.
+
+   A fixed-point number X stands for X / F.  In the names below,
+   `x' and `y' are fixed-point numbers and `n' is an integer.
+   Everything is static inline, so each operation compiles down
+   to one or two instructions at its call site. */
+#define F (1 << 14)
+
+static inline int
+int_to_fp (int n) {
+	return n * F;
+}
+
+/* Rounds toward zero. */
+static inline int
+fp_to_int (int x) {
+	return x / F;
+}
+
+/* Rounds to nearest. */
+static inline int
+fp_to_int_round (int x) {
+	return x >= 0 ? (x + F / 2) / F : (x - F / 2) / F;
+}
+
+static inline int
+add_fp (int x, int y) {
+	return x + y;
+}
+
+static inline int
+sub_fp (int x, int y) {
+	return x - y;
+}
+
+static inline int
+add_mixed (int x, int n) {
+	return x + n * F;
+}
+
+static inline int
+sub_mixed (int x, int n) {
+	return x - n * F;
+}
+
+static inline int
+mult_fp (int x, int y) {
+	return ((int64_t) x) * y / F;
+}
+
+static inline int
+mult_mixed (int x, int n) {
+	return x * n;
+}
+
+static inline int
+div_fp (int x, int y) {
+	return ((int64_t) x) * F / y;
+}
+
+static inline int
+div_mixed (int x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed_point.h */
@@ -2,9 +2,25 @@
 #define THREADS_MALLOC_H
 
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/* Number of malloc() size classes: 16, 32, ..., 1024 bytes. */
+#define MALLOC_CLASS_CNT 7
+
+/* A thread's private cache of free blocks, one chain per size
+   class.  See malloc.c. */
+struct malloc_magazine {
+	void *head[MALLOC_CLASS_CNT];       /* First free block. */
+	uint8_t cnt[MALLOC_CLASS_CNT];      /* Number of free blocks. */
+};
+
+/* If false, malloc() and free() bypass the magazines. */
+extern bool malloc_use_magazines;
 
 void malloc_init (void);
+void malloc_drain (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
@@ -0,0 +1,20 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches for frequently allocated fixed-size objects.
+   See slab.c for details. */
+
+struct kmem_cache;
+
+/* Puts a freshly carved object into its constructed state. */
+typedef void kmem_ctor (void *obj);
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      kmem_ctor *ctor);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_print_stats (struct kmem_cache *);
+
+#endif /* threads/slab.h */
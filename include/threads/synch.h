@@ -2,6 +2,7 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <heap.h>
 #include <stdbool.h>
 #include <debug.h>
 
@@ -9,7 +10,7 @@
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, by priority. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -18,27 +19,48 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+struct thread;
+void synch_priority_changed (struct thread *);
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
 	struct list_elem elem;
+	int max_priority;           /* Highest priority among waiters. */
+	struct heap_elem held_elem; /* Element in holder's `held_locks'. */
 };
 
 void lock_init (struct lock *);
-bool donations_priority_more(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock {
+	struct lock lock;           /* Held by the writer, and by a
+	                               writer waiting for readers. */
+	unsigned readers;           /* Number of readers inside. */
+	bool draining;              /* A writer waits for readers to leave. */
+	struct semaphore drained;   /* Upped by the last reader to leave. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+bool rwlock_try_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+bool rwlock_try_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting semaphore_elems, by priority. */
 };
 
 void cond_init (struct condition *);
-bool sema_priority_more (const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
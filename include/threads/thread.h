@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include "threads/synch.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -37,6 +38,9 @@ typedef int tid_t;
 /* system call */
 #define FDT_PAGES 3
 #define FDCOUNT_LIMIT FDT_PAGES *(1 << 9)
+/* fd_table entries that stand for the console instead of a file. */
+#define STDIN_MARKER ((struct file *) 1)
+#define STDOUT_MARKER ((struct file *) 2)
 
 /* A kernel thread or user process.
  *
@@ -91,10 +95,11 @@ typedef int tid_t;
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
  * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * sleep list (thread.c).  It can be used these two ways only
+ * because they are mutually exclusive: only a thread in the
+ * ready state is on the run queue, whereas only a blocked thread
+ * is on the sleep list.  A thread blocked on a semaphore is
+ * instead in the semaphore's waiter heap, through `sema_elem'. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
@@ -103,21 +108,34 @@ struct thread {
 	int priority;                       /* Priority. */
 	
 
+	struct list_elem all_elem;          /* Element in all threads list. */
+
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
+	/* Owned by synch.c. */
+	struct heap_elem sema_elem;         /* Semaphore waiter heap element. */
+	struct heap *wait_heap;             /* Waiter heap ordered by this
+	                                       thread's priority, or null. */
+	struct heap_elem *wait_heap_elem;   /* Element in `wait_heap'. */
+
 	/* 깨어나야 할 틱 저장 */
 	int64_t wake_up_ticks;
 
 	/* Priority donation */
 	int original_priority;				/* boost 이전의 priority */
 	struct lock *waiting_lock;			/* 이 스레드가 사용을 기다리고 있는 락 */
-	struct list donations;				
-	struct list_elem donations_elem;
+	struct heap held_locks;				/* Held locks, by waiters' max priority. */
 
 	/* Advanced Scheduler */
 	int nice;
 	int recent_cpu;
+	int64_t recent_cpu_epoch;           /* Second recent_cpu is up to date
+	                                       as of; behind only while blocked. */
+
+	/* Completely fair scheduler. */
+	uint64_t vruntime;                  /* Run time weighted by nice. */
+	struct heap_elem cfs_elem;          /* Run queue heap element. */
 	
 	/* process */
 	struct list child_list;
@@ -131,6 +149,19 @@ struct thread {
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4; /* Page map level 4 */
+	struct vdso_data *vdso;             /* Kernel view of the vDSO page. */
+	char *stdout_buf;                   /* Pending console output. */
+	size_t stdout_len;                  /* Bytes in stdout_buf. */
+
+	/* Threads of one process share its main thread's page table,
+	   descriptor table, and supplemental page table, which the
+	   main thread tears down once the others are gone. */
+	struct thread *leader;              /* Main thread of the process. */
+	struct list threads;                /* Other threads not yet joined. */
+	int thread_cnt;                     /* Other threads not yet gone. */
+	struct semaphore threads_done;      /* Upped when thread_cnt hits 0. */
+	bool exiting;                       /* Other threads must exit. */
+	struct thread *wait_child;          /* Child in process_wait(), or null. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
@@ -139,6 +170,9 @@ struct thread {
 	uintptr_t intr_rsp;
 #endif
 
+	/* Owned by threads/malloc.c. */
+	struct malloc_magazine magazine;    /* Cached free blocks. */
+
 	/* Owned by thread.c. */
 	struct intr_frame tf;               /* Information for switching */
 	unsigned magic;                     /* Detects stack overflow. */
@@ -147,6 +181,7 @@ struct thread {
 	struct file **fd_table;
 	int fd_idx;
 	struct file *running;
+	struct ring *ring;                  /* Registered by ring_setup(). */
 };
 
 /* If false (default), use round-robin scheduler.
@@ -154,10 +189,15 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_idle_ticks (int64_t n);
 void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
@@ -183,7 +223,6 @@ void thread_set_priority (int);
 
 void refresh_priority (void);
 void donate_priority (void);
-void remove_with_lock (struct lock *lock);
 
 /* MLFQS */
 int thread_get_nice (void);
@@ -197,6 +236,10 @@ void mlfqs_load_avg (void);
 void mlfqs_increment (void);
 void mlfqs_recalc (void);
 
+/* Performs some operation on thread t, given auxiliary data AUX. */
+typedef void thread_action_func (struct thread *t, void *aux);
+void thread_foreach (thread_action_func *, void *aux);
+
 void do_iret (struct intr_frame *tf);
 struct thread *get_child_thread (tid_t tid);
 
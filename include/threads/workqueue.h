@@ -0,0 +1,67 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kernel workqueues.
+
+   A small, fixed pool of kernel threads runs work items handed
+   to it by code that should not do slow work inline, such as
+   interrupt handlers and the page fault path.  Each item belongs
+   to a workqueue, which caps how many of its items may run at
+   once; a queue with a limit of 1 runs its items one at a time,
+   in the order they were queued.
+
+   Work items are embedded in the structure they act on, like
+   list elements, so queueing one never allocates memory and may
+   be done with interrupts off or from an interrupt handler. */
+
+/* Function run by a work item, given its auxiliary data. */
+typedef void work_func (void *aux);
+
+/* A workqueue. */
+struct workqueue {
+	const char *name;           /* Name, for debugging. */
+	int max_active;             /* Most items allowed to run at once. */
+	int active;                 /* Items running now. */
+	int pending;                /* Items waiting for a worker. */
+	struct list flushers;       /* Threads in workqueue_flush(). */
+};
+
+/* States of a work item. */
+enum work_state {
+	WORK_IDLE,                  /* Not queued, or already taken by a worker. */
+	WORK_DELAYED,               /* Waiting for its delay to expire. */
+	WORK_PENDING                /* Waiting for a worker. */
+};
+
+/* A work item. */
+struct work {
+	struct list_elem elem;      /* Delayed or pending list element. */
+	work_func *func;            /* Function to run. */
+	void *aux;                  /* Argument for `func'. */
+	struct workqueue *wq;       /* Queue it was last queued on. */
+	int64_t due;                /* Tick at which a delayed item is due. */
+	enum work_state state;      /* Current state. */
+};
+
+/* General-purpose queue with no concurrency limit of its own. */
+extern struct workqueue system_wq;
+
+void work_pool_init (void);
+void work_pool_start (void);
+
+void workqueue_init (struct workqueue *, const char *name, int max_active);
+void workqueue_flush (struct workqueue *);
+
+void work_init (struct work *, work_func *, void *aux);
+bool queue_work (struct workqueue *, struct work *);
+bool queue_delayed_work (struct workqueue *, struct work *, int64_t ticks);
+bool cancel_work (struct work *);
+
+int64_t work_pool_deadline (void);
+void work_pool_timer (int64_t ticks);
+
+#endif /* threads/workqueue.h */
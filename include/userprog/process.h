@@ -9,6 +9,10 @@ tid_t process_fork (const char *name, struct intr_frame *if_);
 int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
+tid_t process_create_thread (uintptr_t entry, uint64_t arg0, uint64_t arg1,
+		uintptr_t stack);
+int process_join_thread (tid_t);
+void process_interrupt (struct thread *leader);
 void process_activate (struct thread *next);
 
 bool lazy_load_segment (struct page *page, void *aux);
@@ -2,15 +2,23 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <debug.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct intr_frame;
+struct iovec;
+struct ring;
+
 typedef int tid_t;
 
 void check_address(void *addr);
 int add_file_to_fd_table (struct file *file);
 void halt(void);
 void exit (int status);
-tid_t fork (const char *thread_name);
+tid_t fork (const char *thread_name, struct intr_frame *if_);
 int exec (const char *file);
-int wait (pid_t);
+int wait (tid_t);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
 int open (const char *file);
@@ -20,7 +28,20 @@ int write (int fd, const void *buffer, unsigned length);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pipe (int *fds);
+int dup2 (int oldfd, int newfd);
+int ring_setup (struct ring *ring);
+int ring_submit (unsigned to_submit);
+int futex (int *uaddr, int op, int val);
+tid_t uthread_create (void *entry, uint64_t arg0, uint64_t arg1, void *stack);
+int uthread_join (tid_t tid);
+void uthread_exit (void) NO_RETURN;
 
+void stdout_flush (void);
 void syscall_init (void);
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,13 @@
+#ifndef USERPROG_VDSO_H
+#define USERPROG_VDSO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+bool vdso_map (struct thread *);
+void vdso_unmap (struct thread *);
+void vdso_update (struct thread *, int64_t ticks);
+
+#endif /* userprog/vdso.h */
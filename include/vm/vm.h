@@ -2,8 +2,11 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 /* project 3 */
 #include "lib/kernel/hash.h"
+#include "lib/kernel/ohash.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -61,7 +64,7 @@ struct page {
 	};
 
 	/* project 3 */
-	struct hash_elem hash_elem; /* Hash table element. */
+	struct ohash_elem hash_elem; /* Hash table element. */
 	bool writable;
 	int mapped_page_count;
 };
@@ -93,7 +96,9 @@ struct page_operations {
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-	struct hash spt_hash; /* hash table : should not access directly */
+	struct ohash spt_hash; /* hash table : should not access directly */
+	struct rwlock lock;    /* Read-locked for lookups, write-locked
+	                          for insertions and removals. */
 };
 
 #include "threads/thread.h"
@@ -106,7 +111,14 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+/* Object caches for struct page, struct frame and the
+ * struct load_info handed to lazy loaders as aux. */
+extern struct kmem_cache *page_cachep;
+extern struct kmem_cache *frame_cachep;
+extern struct kmem_cache *load_info_cachep;
+
 void vm_init (void);
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -116,6 +128,7 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+void *vm_exchange_frame (void *va, void *kva);
 enum vm_type page_get_type (struct page *page);
 
 #endif  /* VM_VM_H */
@@ -138,12 +138,16 @@ puts (const char *s) {
 	return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.  The serial
+   port gets the whole buffer at once, rather than one byte per
+   interrupt-disabled section. */
 void
 putbuf (const char *buffer, size_t n) {
 	acquire_console ();
+	write_cnt += n;
+	serial_putbuf ((const uint8_t *) buffer, n);
 	while (n-- > 0)
-		putchar_have_lock (*buffer++);
+		vga_putc (*buffer++);
 	release_console ();
 }
 
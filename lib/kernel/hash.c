@@ -17,6 +17,12 @@ static struct hash_elem *find_elem (struct hash *, struct list *,
 		struct hash_elem *);
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
+static struct hash_elem *lookup (struct hash *, struct hash_elem *);
+static void clear_buckets (struct hash *, struct list *, size_t,
+		hash_action_func *);
+static void apply_buckets (struct hash *, struct list *, size_t,
+		hash_action_func *);
+static void migrate (struct hash *, size_t);
 static void rehash (struct hash *);
 
 /* Initializes hash table H to compute hash values using HASH and
@@ -27,6 +33,9 @@ hash_init (struct hash *h,
 	h->elem_cnt = 0;
 	h->bucket_cnt = 4;
 	h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+	h->old_bucket_cnt = 0;
+	h->old_buckets = NULL;
+	h->migrate_idx = 0;
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
@@ -49,19 +58,13 @@ hash_init (struct hash *h,
    whether done in DESTRUCTOR or elsewhere. */
 void
 hash_clear (struct hash *h, hash_action_func *destructor) {
-	size_t i;
-
-	for (i = 0; i < h->bucket_cnt; i++) {
-		struct list *bucket = &h->buckets[i];
-
-		if (destructor != NULL)
-			while (!list_empty (bucket)) {
-				struct list_elem *list_elem = list_pop_front (bucket);
-				struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
-				destructor (hash_elem, h->aux);
-			}
-
-		list_init (bucket);
+	clear_buckets (h, h->buckets, h->bucket_cnt, destructor);
+	if (h->old_buckets != NULL) {
+		clear_buckets (h, h->old_buckets, h->old_bucket_cnt, destructor);
+		free (h->old_buckets);
+		h->old_buckets = NULL;
+		h->old_bucket_cnt = 0;
+		h->migrate_idx = 0;
 	}
 
 	h->elem_cnt = 0;
@@ -81,6 +84,7 @@ void
 hash_destroy (struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear (h, destructor);
+	free (h->old_buckets);
 	free (h->buckets);
 }
 
@@ -90,16 +94,10 @@ hash_destroy (struct hash *h, hash_action_func *destructor) {
    without inserting NEW. */
 struct hash_elem *
 hash_insert (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
-	//printf("[hash_insert] %p, %p, %p\n", bucket, old, new);
-
-	if (old == NULL){
-		//printf("[hash_insert] old==NULL\n");
-		insert_elem (h, bucket, new);
-		//printf("[hash_insert] inserted finished\n");
-	}
-		
+	struct hash_elem *old = lookup (h, new);
+
+	if (old == NULL)
+		insert_elem (h, find_bucket (h, new), new);
 
 	rehash (h);
 
@@ -110,12 +108,11 @@ hash_insert (struct hash *h, struct hash_elem *new) {
    already in the table, which is returned. */
 struct hash_elem *
 hash_replace (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
+	struct hash_elem *old = lookup (h, new);
 
 	if (old != NULL)
 		remove_elem (h, old);
-	insert_elem (h, bucket, new);
+	insert_elem (h, find_bucket (h, new), new);
 
 	rehash (h);
 
@@ -126,8 +123,7 @@ hash_replace (struct hash *h, struct hash_elem *new) {
    null pointer if no equal element exists in the table. */
 struct hash_elem *
 hash_find (struct hash *h, struct hash_elem *e) {
-	//printf("[hash_find] h: %p /hash_elem: %p \n");
-	return find_elem (h, find_bucket (h, e), e);
+	return lookup (h, e);
 }
 
 /* Finds, removes, and returns an element equal to E in hash
@@ -139,7 +135,7 @@ hash_find (struct hash *h, struct hash_elem *e) {
    responsibility to deallocate them. */
 struct hash_elem *
 hash_delete (struct hash *h, struct hash_elem *e) {
-	struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+	struct hash_elem *found = lookup (h, e);
 	if (found != NULL) {
 		remove_elem (h, found);
 		rehash (h);
@@ -155,19 +151,11 @@ hash_delete (struct hash *h, struct hash_elem *e) {
    undefined behavior, whether done from ACTION or elsewhere. */
 void
 hash_apply (struct hash *h, hash_action_func *action) {
-	size_t i;
-
 	ASSERT (action != NULL);
 
-	for (i = 0; i < h->bucket_cnt; i++) {
-		struct list *bucket = &h->buckets[i];
-		struct list_elem *elem, *next;
-
-		for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) {
-			next = list_next (elem);
-			action (list_elem_to_hash_elem (elem), h->aux);
-		}
-	}
+	apply_buckets (h, h->buckets, h->bucket_cnt, action);
+	if (h->old_buckets != NULL)
+		apply_buckets (h, h->old_buckets, h->old_bucket_cnt, action);
 }
 
 /* Initializes I for iterating hash table H.
@@ -211,7 +199,15 @@ hash_next (struct hash_iterator *i) {
 
 	i->elem = list_elem_to_hash_elem (list_next (&i->elem->list_elem));
 	while (i->elem == list_elem_to_hash_elem (list_end (i->bucket))) {
-		if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt) {
+		struct hash *h = i->hash;
+
+		/* After the last current bucket, go on to the old buckets,
+		   if a resize is in progress. */
+		if (++i->bucket == h->buckets + h->bucket_cnt
+				&& h->old_buckets != NULL)
+			i->bucket = h->old_buckets;
+		else if (i->bucket == h->buckets + h->bucket_cnt
+				|| i->bucket == h->old_buckets + h->old_bucket_cnt) {
 			i->elem = NULL;
 			break;
 		}
@@ -289,6 +285,59 @@ find_bucket (struct hash *h, struct hash_elem *e) {
 	return &h->buckets[bucket_idx];
 }
 
+/* Searches H, including any old buckets still being drained, for
+   a hash element equal to E.  Returns it if found or a null
+   pointer otherwise. */
+static struct hash_elem *
+lookup (struct hash *h, struct hash_elem *e) {
+	struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+
+	if (found == NULL && h->old_buckets != NULL) {
+		size_t idx = h->hash (e, h->aux) & (h->old_bucket_cnt - 1);
+		found = find_elem (h, &h->old_buckets[idx], e);
+	}
+	return found;
+}
+
+/* Empties the BUCKET_CNT buckets at BUCKETS in H, calling
+   DESTRUCTOR, if non-null, for each element. */
+static void
+clear_buckets (struct hash *h, struct list *buckets, size_t bucket_cnt,
+		hash_action_func *destructor) {
+	size_t i;
+
+	for (i = 0; i < bucket_cnt; i++) {
+		struct list *bucket = &buckets[i];
+
+		if (destructor != NULL)
+			while (!list_empty (bucket)) {
+				struct list_elem *list_elem = list_pop_front (bucket);
+				struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
+				destructor (hash_elem, h->aux);
+			}
+
+		list_init (bucket);
+	}
+}
+
+/* Calls ACTION for each element in the BUCKET_CNT buckets at
+   BUCKETS in H. */
+static void
+apply_buckets (struct hash *h, struct list *buckets, size_t bucket_cnt,
+		hash_action_func *action) {
+	size_t i;
+
+	for (i = 0; i < bucket_cnt; i++) {
+		struct list *bucket = &buckets[i];
+		struct list_elem *elem, *next;
+
+		for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) {
+			next = list_next (elem);
+			action (list_elem_to_hash_elem (elem), h->aux);
+		}
+	}
+}
+
 /* Searches BUCKET in H for a hash element equal to E.  Returns
    it if found or a null pointer otherwise. */
 static struct hash_elem *
@@ -320,21 +369,57 @@ is_power_of_2 (size_t x) {
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
 #define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
-/* Changes the number of buckets in hash table H to match the
-   ideal.  This function can fail because of an out-of-memory
+/* Old buckets drained per insertion or deletion while a resize
+   is in progress. */
+#define MIGRATE_STEP 2
+
+/* Moves the elements of up to BUCKETS old buckets of H into the
+   current ones, and frees the old array once all of its buckets
+   have been drained. */
+static void
+migrate (struct hash *h, size_t buckets) {
+	while (h->old_buckets != NULL && buckets-- > 0) {
+		struct list *old_bucket = &h->old_buckets[h->migrate_idx];
+
+		while (!list_empty (old_bucket)) {
+			struct list_elem *elem = list_pop_front (old_bucket);
+			list_push_front (find_bucket (h, list_elem_to_hash_elem (elem)),
+					elem);
+		}
+
+		if (++h->migrate_idx == h->old_bucket_cnt) {
+			free (h->old_buckets);
+			h->old_buckets = NULL;
+			h->old_bucket_cnt = 0;
+			h->migrate_idx = 0;
+		}
+	}
+}
+
+/* Moves hash table H along toward the ideal number of buckets.
+
+   If a resize is in progress, drains MIGRATE_STEP more of the
+   old buckets.  Otherwise, if the bucket count no longer matches
+   the ideal, installs a new, empty bucket array and keeps the old
+   one to be drained by later calls, so that the cost of a resize
+   is spread over the operations that follow it instead of falling
+   on one caller.
+
+   Allocating the new array can fail because of an out-of-memory
    condition, but that'll just make hash accesses less efficient;
    we can still continue. */
 static void
 rehash (struct hash *h) {
-	size_t old_bucket_cnt, new_bucket_cnt;
-	struct list *new_buckets, *old_buckets;
+	size_t new_bucket_cnt;
+	struct list *new_buckets;
 	size_t i;
 
 	ASSERT (h != NULL);
 
-	/* Save old bucket info for later use. */
-	old_buckets = h->buckets;
-	old_bucket_cnt = h->bucket_cnt;
+	if (h->old_buckets != NULL) {
+		migrate (h, MIGRATE_STEP);
+		return;
+	}
 
 	/* Calculate the number of buckets to use now.
 	   We want one bucket for about every BEST_ELEMS_PER_BUCKET.
@@ -347,7 +432,7 @@ rehash (struct hash *h) {
 		new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
 
 	/* Don't do anything if the bucket count wouldn't change. */
-	if (new_bucket_cnt == old_bucket_cnt)
+	if (new_bucket_cnt == h->bucket_cnt)
 		return;
 
 	/* Allocate new buckets and initialize them as empty. */
@@ -361,27 +446,14 @@ rehash (struct hash *h) {
 	for (i = 0; i < new_bucket_cnt; i++)
 		list_init (&new_buckets[i]);
 
-	/* Install new bucket info. */
+	/* Install new bucket info, keeping the old buckets to drain. */
+	h->old_buckets = h->buckets;
+	h->old_bucket_cnt = h->bucket_cnt;
+	h->migrate_idx = 0;
 	h->buckets = new_buckets;
 	h->bucket_cnt = new_bucket_cnt;
 
-	/* Move each old element into the appropriate new bucket. */
-	for (i = 0; i < old_bucket_cnt; i++) {
-		struct list *old_bucket;
-		struct list_elem *elem, *next;
-
-		old_bucket = &old_buckets[i];
-		for (elem = list_begin (old_bucket);
-				elem != list_end (old_bucket); elem = next) {
-			struct list *new_bucket
-				= find_bucket (h, list_elem_to_hash_elem (elem));
-			next = list_next (elem);
-			list_remove (elem);
-			list_push_front (new_bucket, elem);
-		}
-	}
-
-	free (old_buckets);
+	migrate (h, MIGRATE_STEP);
 }
 
 /* Inserts E into BUCKET (in hash table H). */
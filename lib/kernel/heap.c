@@ -0,0 +1,200 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a tree in which every node is at least as
+   great as its children, which are kept in a doubly linked
+   sibling list hanging off the node's `child' pointer.  The
+   leftmost child's `prev' points to the parent instead of a
+   sibling.
+
+   Melding two trees makes the lesser root the leftmost child of
+   the greater one.  Popping the root melds its children back
+   into one tree in two passes: first in pairs from left to
+   right, then the pairs from right to left, which is what gives
+   the O(log n) amortized bound. */
+
+/* Returns true if A should come out of H before B. */
+static inline bool
+precedes (struct heap *h, const struct heap_elem *a,
+		const struct heap_elem *b) {
+	if (h->less (b, a, h->aux))
+		return true;
+	if (h->less (a, b, h->aux))
+		return false;
+	return a->seq < b->seq;
+}
+
+/* Melds the trees rooted at A and B and returns the new root.
+   The sibling links of A and B are ignored and the returned
+   root's are cleared. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (precedes (h, b, a)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* Left to right: meld each pair and push the result onto
+	   PAIRS, which ends up in right-to-left order. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		if (b != NULL) {
+			first = b->next;
+			a = meld (h, a, b);
+		} else
+			first = NULL;
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Right to left: meld each pair into the result. */
+	while (pairs != NULL) {
+		struct heap_elem *a = pairs;
+
+		pairs = a->next;
+		root = root != NULL ? meld (h, root, a) : a;
+	}
+
+	if (root != NULL)
+		root->next = root->prev = NULL;
+	return root;
+}
+
+/* Unlinks non-root element E, with its subtree, from its parent
+   and siblings. */
+static void
+detach (struct heap_elem *e) {
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
+
+/* Adds E, which keeps its sequence number, to H. */
+static void
+insert (struct heap *h, struct heap_elem *e) {
+	e->child = e->next = e->prev = NULL;
+	h->root = h->root != NULL ? meld (h, h->root, e) : e;
+	h->size++;
+}
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->next_seq = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Adds E to H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->seq = h->next_seq++;
+	insert (h, e);
+}
+
+/* Returns the greatest element in H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top (struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Removes and returns the greatest element in H, which must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (h != NULL);
+	ASSERT (h->root != NULL);
+
+	top = h->root;
+	h->root = merge_pairs (h, top->child);
+	h->size--;
+	top->child = NULL;
+	return top;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *sub;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	detach (e);
+	sub = merge_pairs (h, e->child);
+	if (sub != NULL)
+		h->root = meld (h, h->root, sub);
+	h->size--;
+	e->child = NULL;
+}
+
+/* Restores H's order after the key of E, which must be in H, has
+   changed in either direction.  E keeps its place among elements
+   that compare equal to it. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	heap_remove (h, e);
+	insert (h, e);
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root == NULL;
+}
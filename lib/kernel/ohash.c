@@ -0,0 +1,431 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include "../debug.h"
+#include <string.h>
+#include "threads/malloc.h"
+
+/* A table grows once more than MAX_LOAD_NUM / MAX_LOAD_DEN of
+   its slots would be occupied. */
+#define MAX_LOAD_NUM 7
+#define MAX_LOAD_DEN 8
+
+/* Slots of the old table visited per insertion or deletion while
+   a resize is in progress. */
+#define MIGRATE_STEP 8
+
+/* Slots in a freshly initialized table. */
+#define INITIAL_SLOTS 8
+
+static bool table_init (struct ohash_table *, size_t slot_cnt);
+static size_t table_find (struct ohash *, struct ohash_table *, uint64_t hash,
+		struct ohash_elem *);
+static void table_put (struct ohash_table *, uint64_t hash,
+		struct ohash_elem *);
+static void table_remove (struct ohash_table *, size_t idx);
+static bool make_room (struct ohash *);
+static void migrate (struct ohash *, size_t steps);
+
+/* Returned by table_find() when there is no match. */
+#define NOT_FOUND SIZE_MAX
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX. */
+bool
+ohash_init (struct ohash *h,
+		ohash_hash_func *hash, ohash_less_func *less, void *aux) {
+	h->elem_cnt = 0;
+	h->old.slots = NULL;
+	h->old.slot_cnt = h->old.elem_cnt = 0;
+	h->migrate_idx = 0;
+	h->hash = hash;
+	h->less = less;
+	h->aux = aux;
+	return table_init (&h->cur, INITIAL_SLOTS);
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere. */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor) {
+	if (destructor != NULL)
+		ohash_apply (h, destructor);
+
+	free (h->old.slots);
+	h->old.slots = NULL;
+	h->old.slot_cnt = h->old.elem_cnt = 0;
+	h->migrate_idx = 0;
+
+	memset (h->cur.slots, 0, sizeof *h->cur.slots * h->cur.slot_cnt);
+	h->cur.elem_cnt = 0;
+	h->elem_cnt = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, with the same restrictions as for
+   ohash_clear(). */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor) {
+	if (destructor != NULL)
+		ohash_apply (h, destructor);
+	free (h->old.slots);
+	free (h->cur.slots);
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW.
+   If the table is full and cannot be grown for lack of memory,
+   returns NEW itself without inserting it. */
+struct ohash_elem *
+ohash_insert (struct ohash *h, struct ohash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	struct ohash_table *tables[2] = { &h->cur, &h->old };
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		size_t idx = table_find (h, tables[i], hash, new);
+		if (idx != NOT_FOUND)
+			return tables[i]->slots[idx].elem;
+	}
+
+	migrate (h, MIGRATE_STEP);
+	if (!make_room (h))
+		return new;
+	table_put (&h->cur, hash, new);
+	h->elem_cnt++;
+	return NULL;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned.
+   If there is no equal element and the table is full and cannot
+   be grown for lack of memory, returns NEW itself without
+   inserting it. */
+struct ohash_elem *
+ohash_replace (struct ohash *h, struct ohash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	struct ohash_table *tables[2] = { &h->cur, &h->old };
+	int i;
+
+	/* An equal element has the same hash value, so NEW can simply
+	   take over its slot. */
+	for (i = 0; i < 2; i++) {
+		size_t idx = table_find (h, tables[i], hash, new);
+
+		if (idx != NOT_FOUND) {
+			struct ohash_elem *old = tables[i]->slots[idx].elem;
+			tables[i]->slots[idx].elem = new;
+			return old;
+		}
+	}
+
+	migrate (h, MIGRATE_STEP);
+	if (!make_room (h))
+		return new;
+	table_put (&h->cur, hash, new);
+	h->elem_cnt++;
+	return NULL;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct ohash_elem *
+ohash_find (struct ohash *h, struct ohash_elem *e) {
+	uint64_t hash = h->hash (e, h->aux);
+	size_t idx;
+
+	idx = table_find (h, &h->cur, hash, e);
+	if (idx != NOT_FOUND)
+		return h->cur.slots[idx].elem;
+	idx = table_find (h, &h->old, hash, e);
+	if (idx != NOT_FOUND)
+		return h->old.slots[idx].elem;
+	return NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e) {
+	uint64_t hash = h->hash (e, h->aux);
+	struct ohash_table *tables[2] = { &h->cur, &h->old };
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		size_t idx = table_find (h, tables[i], hash, e);
+
+		if (idx != NOT_FOUND) {
+			struct ohash_elem *found = tables[i]->slots[idx].elem;
+			table_remove (tables[i], idx);
+			h->elem_cnt--;
+			migrate (h, MIGRATE_STEP);
+			return found;
+		}
+	}
+	return NULL;
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action) {
+	struct ohash_table *tables[2] = { &h->cur, &h->old };
+	size_t i;
+	int t;
+
+	ASSERT (action != NULL);
+
+	for (t = 0; t < 2; t++)
+		for (i = 0; i < tables[t]->slot_cnt; i++)
+			if (tables[t]->slots[i].elem != NULL)
+				action (tables[t]->slots[i].elem, h->aux);
+}
+
+/* Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+   struct ohash_iterator i;
+
+   ohash_first (&i, h);
+   while (ohash_next (&i))
+   {
+   struct foo *f = ohash_entry (ohash_cur (&i), struct foo, elem);
+   ...do something with f...
+   }
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h) {
+	ASSERT (i != NULL);
+	ASSERT (h != NULL);
+
+	i->hash = h;
+	i->table = &h->cur;
+	i->idx = SIZE_MAX;
+	i->elem = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order. */
+struct ohash_elem *
+ohash_next (struct ohash_iterator *i) {
+	ASSERT (i != NULL);
+
+	for (;;) {
+		if (++i->idx >= i->table->slot_cnt) {
+			if (i->table == &i->hash->old) {
+				i->elem = NULL;
+				break;
+			}
+			i->table = &i->hash->old;
+			i->idx = SIZE_MAX;
+			continue;
+		}
+		i->elem = i->table->slots[i->idx].elem;
+		if (i->elem != NULL)
+			break;
+	}
+
+	return i->elem;
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct ohash_elem *
+ohash_cur (struct ohash_iterator *i) {
+	return i->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) {
+	return h->elem_cnt == 0;
+}
+
+/* Initializes T with SLOT_CNT empty slots.  Returns false if
+   memory is not available. */
+static bool
+table_init (struct ohash_table *t, size_t slot_cnt) {
+	t->slots = calloc (slot_cnt, sizeof *t->slots);
+	t->slot_cnt = t->slots != NULL ? slot_cnt : 0;
+	t->elem_cnt = 0;
+	return t->slots != NULL;
+}
+
+/* Returns how far slot IDX of T, whose occupant has hash value
+   HASH, is from that occupant's home slot. */
+static inline size_t
+probe_dist (const struct ohash_table *t, size_t idx, uint64_t hash) {
+	return (idx - hash) & (t->slot_cnt - 1);
+}
+
+/* Searches T in H for an element equal to E, which has hash
+   value HASH.  Returns its slot index, or NOT_FOUND. */
+static size_t
+table_find (struct ohash *h, struct ohash_table *t, uint64_t hash,
+		struct ohash_elem *e) {
+	size_t mask = t->slot_cnt - 1;
+	size_t idx, dist;
+
+	if (t->elem_cnt == 0)
+		return NOT_FOUND;
+
+	for (idx = hash & mask, dist = 0; ; idx = (idx + 1) & mask, dist++) {
+		struct ohash_slot *s = &t->slots[idx];
+
+		/* Past the point where E would have displaced the
+		   occupant, so E is not here. */
+		if (s->elem == NULL || probe_dist (t, idx, s->hash) < dist)
+			return NOT_FOUND;
+		if (s->hash == hash
+				&& !h->less (s->elem, e, h->aux) && !h->less (e, s->elem, h->aux))
+			return idx;
+	}
+}
+
+/* Inserts E, which has hash value HASH, into T, which must have
+   an empty slot.  Walks E's probe run and swaps it with the
+   first occupant closer to its own home slot than E is, carrying
+   that occupant on in the same way, until an empty slot is
+   reached. */
+static void
+table_put (struct ohash_table *t, uint64_t hash, struct ohash_elem *e) {
+	size_t mask = t->slot_cnt - 1;
+	struct ohash_slot carry = { hash, e };
+	size_t idx, dist;
+
+	ASSERT (t->elem_cnt < t->slot_cnt);
+
+	for (idx = hash & mask, dist = 0; ; idx = (idx + 1) & mask, dist++) {
+		struct ohash_slot *s = &t->slots[idx];
+		size_t s_dist;
+
+		if (s->elem == NULL) {
+			*s = carry;
+			break;
+		}
+
+		s_dist = probe_dist (t, idx, s->hash);
+		if (s_dist < dist) {
+			struct ohash_slot tmp = *s;
+			*s = carry;
+			carry = tmp;
+			dist = s_dist;
+		}
+	}
+	t->elem_cnt++;
+}
+
+/* Empties slot IDX of T, then moves each following element of
+   the probe run back by one slot, stopping at an empty slot or
+   at an element already in its home slot. */
+static void
+table_remove (struct ohash_table *t, size_t idx) {
+	size_t mask = t->slot_cnt - 1;
+
+	for (;;) {
+		size_t next = (idx + 1) & mask;
+		struct ohash_slot *s = &t->slots[next];
+
+		if (s->elem == NULL || probe_dist (t, next, s->hash) == 0)
+			break;
+		t->slots[idx] = *s;
+		idx = next;
+	}
+	t->slots[idx].elem = NULL;
+	t->elem_cnt--;
+}
+
+/* Makes sure H's current table has room for one more element
+   within its load limit, starting a resize if not.  Returns
+   false only if the table is full and a larger one could not be
+   allocated; below that, failing to grow just leaves the table
+   more heavily loaded. */
+static bool
+make_room (struct ohash *h) {
+	struct ohash_table bigger;
+
+	if ((h->elem_cnt + 1) * MAX_LOAD_DEN <= h->cur.slot_cnt * MAX_LOAD_NUM)
+		return true;
+
+	/* A resize still in flight must finish before the next one.
+	   With MIGRATE_STEP well above 1 this is rare. */
+	migrate (h, SIZE_MAX);
+
+	if (table_init (&bigger, h->cur.slot_cnt * 2)) {
+		h->old = h->cur;
+		h->cur = bigger;
+		h->migrate_idx = 0;
+		return true;
+	}
+	return h->cur.elem_cnt < h->cur.slot_cnt;
+}
+
+/* Moves elements from H's old table to its current one, visiting
+   at most STEPS old slots, and frees the old table once it is
+   empty.
+
+   Slots are visited in index order.  Removing an element lets
+   table_remove() pull its successor into the same slot, so the
+   index only advances past empty slots; everything below it stays
+   empty, which keeps the old table's probe runs intact for
+   searches in the meantime. */
+static void
+migrate (struct ohash *h, size_t steps) {
+	struct ohash_table *old = &h->old;
+
+	if (old->slots == NULL)
+		return;
+
+	while (steps-- > 0 && old->elem_cnt > 0) {
+		struct ohash_slot *s = &old->slots[h->migrate_idx];
+
+		if (s->elem == NULL)
+			h->migrate_idx++;
+		else {
+			table_put (&h->cur, s->hash, s->elem);
+			table_remove (old, h->migrate_idx);
+		}
+	}
+
+	if (old->elem_cnt == 0) {
+		free (old->slots);
+		old->slots = NULL;
+		old->slot_cnt = 0;
+		h->migrate_idx = 0;
+	}
+}
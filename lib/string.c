@@ -1,43 +1,96 @@
 #include <string.h>
+#include <stdint.h>
 #include <debug.h>
 
+/* Word-at-a-time string scanning.  HAS_ZERO(X) is nonzero iff
+   some byte of X is zero, and its lowest set bit lies in the
+   lowest such byte (higher bits may be false positives, which
+   is why only the lowest is ever used).  Loads are kept from
+   crossing a PAGE_SIZE boundary, so a scan never faults on a
+   page that the string itself does not reach. */
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+#define HAS_ZERO(X) (((X) - ONES) & ~(X) & HIGHS)
+#define PAGE_SIZE 4096
+
+/* Returns the index of the byte that HAS_ZERO flagged in MASK. */
+static inline size_t
+flagged_byte (uint64_t mask) {
+	return __builtin_ctzll (mask) / 8;
+}
+
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
-   Returns DST. */
+   Returns DST.
+
+   Blocks of 16 bytes or more are moved a word at a time with
+   `rep movsq', after bringing DST up to an 8-byte boundary, and
+   any leftover bytes with `rep movsb'.  When both pointers and
+   SIZE are already multiples of 8, as for whole pages, the
+   alignment steps are skipped entirely. */
 void *
 memcpy (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
 	const unsigned char *src = src_;
+	size_t cnt;
 
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+	if ((((uintptr_t) dst | (uintptr_t) src | size) & 7) == 0) {
+		cnt = size / 8;
+		asm volatile ("rep movsq"
+				: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+		return dst_;
+	}
+
+	if (size >= 16) {
+		cnt = -(uintptr_t) dst & 7;
+		size -= cnt;
+		asm volatile ("rep movsb"
+				: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+		cnt = size / 8;
+		size &= 7;
+		asm volatile ("rep movsq"
+				: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+	}
+	asm volatile ("rep movsb"
+			: "+D" (dst), "+S" (src), "+c" (size) : : "memory");
 
 	return dst_;
 }
 
 /* Copies SIZE bytes from SRC to DST, which are allowed to
-   overlap.  Returns DST. */
+   overlap.  Returns DST.
+
+   Copies forward with memcpy() unless DST lies inside the
+   source block, in which case it copies backward with the
+   direction flag set: first the odd tail bytes, then whole
+   words.  The flag is cleared again before returning, since the
+   ABI requires it clear on function entry and exit. */
 void *
 memmove (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
 	const unsigned char *src = src_;
+	size_t cnt;
 
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
-	}
+	if (dst <= src || dst >= src + size)
+		return memcpy (dst, src, size);
 
-	return dst;
+	dst += size - 1;
+	src += size - 1;
+	cnt = size & 7;
+	asm volatile ("std; rep movsb; cld"
+			: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+	dst -= 7;
+	src -= 7;
+	cnt = size / 8;
+	asm volatile ("std; rep movsq; cld"
+			: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -49,9 +102,25 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	const unsigned char *a = a_;
 	const unsigned char *b = b_;
 
+	size_t words = size / 8;
+
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	/* Skip the equal prefix a word at a time.  `repe cmpsq' stops
+	   just past the first differing word, or past the last word if
+	   none differ; either way, back up over that word and let the
+	   byte loop below find the exact difference, if any. */
+	if (words > 0) {
+		const unsigned char *start = a;
+
+		asm volatile ("repe cmpsq"
+				: "+S" (a), "+D" (b), "+c" (words) : : "memory", "cc");
+		a -= 8;
+		b -= 8;
+		size -= a - start;
+	}
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -71,6 +140,33 @@ strcmp (const char *a_, const char *b_) {
 	ASSERT (a != NULL);
 	ASSERT (b != NULL);
 
+	/* Compare a byte at a time until A is word-aligned, then a
+	   word at a time while the words match and hold no null.  A
+	   is aligned so its loads are safe; B may not be, so a word
+	   of B that would straddle a page is compared bytewise. */
+	for (; (uintptr_t) a % 8 != 0; a++, b++)
+		if (*a == '\0' || *a != *b)
+			return *a < *b ? -1 : *a > *b;
+
+	for (;;) {
+		uint64_t wa;
+
+		if ((uintptr_t) b % PAGE_SIZE > PAGE_SIZE - 8) {
+			const unsigned char *end = a + 8;
+
+			for (; a < end; a++, b++)
+				if (*a == '\0' || *a != *b)
+					return *a < *b ? -1 : *a > *b;
+			continue;
+		}
+
+		wa = *(const uint64_t *) a;
+		if (wa != *(const uint64_t *) b || HAS_ZERO (wa))
+			break;
+		a += 8;
+		b += 8;
+	}
+
 	while (*a != '\0' && *a == *b) {
 		a++;
 		b++;
@@ -103,16 +199,27 @@ memchr (const void *block_, int ch_, size_t size) {
 char *
 strchr (const char *string, int c_) {
 	char c = c_;
+	uint64_t pattern = (unsigned char) c * ONES;
+	const uint64_t *w;
 
 	ASSERT (string);
 
-	for (;;)
+	for (; (uintptr_t) string % 8 != 0; string++)
 		if (*string == c)
 			return (char *) string;
 		else if (*string == '\0')
 			return NULL;
-		else
-			string++;
+
+	/* Aligned words never cross a page.  The lowest byte flagged
+	   as either C or null is the first of either in the string. */
+	for (w = (const uint64_t *) string; ; w++) {
+		uint64_t mask = HAS_ZERO (*w) | HAS_ZERO (*w ^ pattern);
+
+		if (mask != 0) {
+			string = (const char *) w + flagged_byte (mask);
+			return *string == c ? (char *) string : NULL;
+		}
+	}
 }
 
 /* Returns the length of the initial substring of STRING that
@@ -253,15 +360,30 @@ strtok_r (char *s, const char *delimiters, char **save_ptr) {
 	return token;
 }
 
-/* Sets the SIZE bytes in DST to VALUE. */
+/* Sets the SIZE bytes in DST to VALUE.
+
+   Like memcpy(), fills whole words with `rep stosq' once DST is
+   8-byte aligned, and the rest with `rep stosb'. */
 void *
 memset (void *dst_, int value, size_t size) {
 	unsigned char *dst = dst_;
+	uint64_t pattern = (unsigned char) value * 0x0101010101010101ULL;
+	size_t cnt;
 
 	ASSERT (dst != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = value;
+	if (size >= 16 || (((uintptr_t) dst | size) & 7) == 0) {
+		cnt = -(uintptr_t) dst & 7;
+		size -= cnt;
+		asm volatile ("rep stosb"
+				: "+D" (dst), "+c" (cnt) : "a" (pattern) : "memory");
+		cnt = size / 8;
+		size &= 7;
+		asm volatile ("rep stosq"
+				: "+D" (dst), "+c" (cnt) : "a" (pattern) : "memory");
+	}
+	asm volatile ("rep stosb"
+			: "+D" (dst), "+c" (size) : "a" (pattern) : "memory");
 
 	return dst_;
 }
@@ -270,12 +392,18 @@ memset (void *dst_, int value, size_t size) {
 size_t
 strlen (const char *string) {
 	const char *p;
+	const uint64_t *w;
+	uint64_t mask;
 
 	ASSERT (string);
 
-	for (p = string; *p != '\0'; p++)
+	for (p = string; (uintptr_t) p % 8 != 0; p++)
+		if (*p == '\0')
+			return p - string;
+
+	for (w = (const uint64_t *) p; (mask = HAS_ZERO (*w)) == 0; w++)
 		continue;
-	return p - string;
+	return (const char *) w + flagged_byte (mask) - string;
 }
 
 /* If STRING is less than MAXLEN characters in length, returns
@@ -300,20 +428,30 @@ http://www.courtesan.com/todd/papers/strlcpy.html for
 information on strlcpy(). */
 size_t
 strlcpy (char *dst, const char *src, size_t size) {
-	size_t src_len;
+	const char *s = src;
 
 	ASSERT (dst != NULL);
 	ASSERT (src != NULL);
 
-	src_len = strlen (src);
+	/* Copy in one pass, a whole word whenever S is aligned, the
+	   word holds no null and DST has room for it, and otherwise a
+	   byte.  Only the part of SRC past the copy is rescanned for
+	   the return value. */
 	if (size > 0) {
-		size_t dst_len = size - 1;
-		if (src_len < dst_len)
-			dst_len = src_len;
-		memcpy (dst, src, dst_len);
-		dst[dst_len] = '\0';
+		char *end = dst + size - 1;
+
+		while (dst < end && *s != '\0') {
+			if ((uintptr_t) s % 8 == 0 && end - dst >= 8
+					&& !HAS_ZERO (*(const uint64_t *) s)) {
+				*(uint64_t *) dst = *(const uint64_t *) s;
+				dst += 8;
+				s += 8;
+			} else
+				*dst++ = *s++;
+		}
+		*dst = '\0';
 	}
-	return src_len;
+	return (s - src) + strlen (s);
 }
 
 /* Concatenates string SRC to DST.  The concatenated string is
@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -145,6 +145,73 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
+int
+ring_setup (struct ring *ring) {
+	return syscall1 (SYS_RING_SETUP, ring);
+}
+
+int
+ring_submit (unsigned to_submit) {
+	return syscall1 (SYS_SUBMIT, to_submit);
+}
+
+int
+futex (int *addr, int op, int val) {
+	return syscall3 (SYS_FUTEX, addr, op, val);
+}
+
+/* Where a new thread starts: runs FUNC (AUX), then ends the
+   thread, since there is nothing to return to. */
+static void
+uthread_start (uthread_func *func, void *aux) {
+	func (aux);
+	uthread_exit ();
+}
+
+/* Starts a thread that runs FUNC (AUX) on the stack whose top is
+   STACK.  Returns the new thread's id, or TID_ERROR. */
+tid_t
+uthread_create (uthread_func *func, void *aux, void *stack) {
+	return (tid_t) syscall4 (SYS_THREAD_CREATE, uthread_start, func, aux,
+			stack);
+}
+
+int
+uthread_join (tid_t tid) {
+	return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+uthread_exit (void) {
+	syscall0 (SYS_THREAD_EXIT);
+	NOT_REACHED ();
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
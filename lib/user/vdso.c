@@ -0,0 +1,24 @@
+#include <syscall.h>
+#include <vdso.h>
+
+/* The kernel updates the page behind our back. */
+static volatile const struct vdso_data *const vdso =
+	(volatile const struct vdso_data *) VDSO_BASE;
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+vdso_ticks (void) {
+	return vdso->ticks;
+}
+
+/* Returns the number of timer ticks per second. */
+int
+vdso_timer_freq (void) {
+	return vdso->timer_freq;
+}
+
+/* Returns the process's own pid. */
+pid_t
+vdso_getpid (void) {
+	return vdso->tid;
+}
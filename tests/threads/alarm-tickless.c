@@ -0,0 +1,45 @@
+/* Sleeps for 5 seconds with the periodic tick stopped while
+   idle, and checks the ticks that passed against the time the
+   TSC measured.  Skipped ticks must be accounted for exactly, or
+   the two clocks drift apart.  Run with -tickless; the .ck also
+   checks that some ticks really were skipped. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define SLEEP_TICKS (5 * TIMER_FREQ)
+
+/* Nanoseconds per timer tick. */
+#define TICK_NS (1000000000 / TIMER_FREQ)
+
+void
+test_alarm_tickless (void) 
+{
+  int64_t start_ticks, ticks;
+  uint64_t start_ns, ns, lo, hi;
+
+  if (!timer_tickless)
+    fail ("must be run with -tickless");
+
+  start_ticks = timer_ticks ();
+  start_ns = timer_now_ns ();
+  timer_sleep (SLEEP_TICKS);
+  ticks = timer_elapsed (start_ticks);
+  ns = timer_now_ns () - start_ns;
+
+  if (ticks < SLEEP_TICKS)
+    fail ("woke up after %"PRId64" ticks", ticks);
+  msg ("Slept at least %d ticks.", SLEEP_TICKS);
+
+  /* We started partway through a tick, so allow one tick either
+     way, plus 5% for the TSC's calibration. */
+  lo = (uint64_t) (ticks - 1) * TICK_NS / 100 * 95;
+  hi = (uint64_t) (ticks + 1) * TICK_NS / 100 * 105;
+  if (ns < lo || ns > hi)
+    fail ("%"PRId64" ticks passed but the TSC measured %"PRIu64" ms",
+          ticks, ns / 1000000);
+  msg ("TSC time matches the tick count.");
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The idle CPU must really have skipped ticks.
+my ($timer) = grep (/^Timer: \d+ ticks/, @output);
+fail "missing \"Timer:\" line\n" if !defined $timer;
+my ($skipped) = $timer =~ /^Timer: \d+ ticks, (\d+) skipped$/
+  or fail "\"Timer:\" line does not report skipped ticks\n";
+fail "no ticks were skipped\n" if $skipped == 0;
+
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) Slept at least 500 ticks.
+(alarm-tickless) TSC time matches the tick count.
+(alarm-tickless) end
+EOF
+pass;
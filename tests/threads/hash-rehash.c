@@ -0,0 +1,128 @@
+/* Tests the chained hash table across its incremental rehashes.
+   Every element stays findable and iteration visits each element
+   exactly once while the table grows, and again while deletions
+   shrink it back down. */
+
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+
+#define ELEM_CNT 1000
+
+struct item
+  {
+    struct hash_elem elem;
+    int key;
+  };
+
+static struct item items[ELEM_CNT];
+static bool seen[ELEM_CNT];
+
+/* Keys in [lo, hi) are in the table. */
+static int lo, hi;
+
+static uint64_t
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
+
+/* Returns the item in H with KEY, or a null pointer. */
+static struct item *
+find (struct hash *h, int key)
+{
+  struct item probe;
+  struct hash_elem *e;
+
+  probe.key = key;
+  e = hash_find (h, &probe.elem);
+  return e != NULL ? hash_entry (e, struct item, elem) : NULL;
+}
+
+/* Fails unless H holds exactly the keys in [lo, hi), each
+   findable and each visited once by an iterator. */
+static void
+check_table (struct hash *h)
+{
+  struct hash_iterator i;
+  size_t cnt = 0;
+  int key;
+
+  for (key = 0; key < ELEM_CNT; key++)
+    {
+      bool present = key >= lo && key < hi;
+      if (find (h, key) != (present ? &items[key] : NULL))
+        fail ("element %d in the wrong state with [%d, %d) inserted",
+              key, lo, hi);
+    }
+
+  memset (seen, 0, sizeof seen);
+  hash_first (&i, h);
+  while (hash_next (&i))
+    {
+      struct item *it = hash_entry (hash_cur (&i), struct item, elem);
+
+      if (it != &items[it->key] || it->key < lo || it->key >= hi)
+        fail ("iteration visited stray element %d", it->key);
+      if (seen[it->key])
+        fail ("iteration visited element %d twice", it->key);
+      seen[it->key] = true;
+      cnt++;
+    }
+  if (cnt != hash_size (h) || cnt != (size_t) (hi - lo))
+    fail ("iteration visited %zu elements of %zu", cnt, hash_size (h));
+}
+
+void
+test_hash_rehash (void)
+{
+  struct hash h;
+  int grow_checks = 0, shrink_checks = 0;
+
+  if (!hash_init (&h, item_hash, item_less, NULL))
+    fail ("hash_init failed");
+
+  for (lo = hi = 0; hi < ELEM_CNT; )
+    {
+      items[hi].key = hi;
+      if (hash_insert (&h, &items[hi].elem) != NULL)
+        fail ("inserting element %d failed", hi);
+      hi++;
+      if (h.old_buckets != NULL)
+        {
+          check_table (&h);
+          grow_checks++;
+        }
+    }
+  if (grow_checks == 0)
+    fail ("no insertion left a rehash in flight");
+  msg ("Inserted %d elements, checking them mid-rehash.", ELEM_CNT);
+
+  while (lo < ELEM_CNT - 10)
+    {
+      if (hash_delete (&h, &items[lo].elem) != &items[lo].elem)
+        fail ("deleting element %d failed", lo);
+      lo++;
+      if (h.old_buckets != NULL)
+        {
+          check_table (&h);
+          shrink_checks++;
+        }
+    }
+  if (shrink_checks == 0)
+    fail ("no deletion left a rehash in flight");
+  check_table (&h);
+  msg ("Deleted all but 10 elements, checking them mid-rehash.");
+
+  hash_destroy (&h, NULL);
+}
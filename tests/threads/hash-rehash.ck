@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(hash-rehash) begin
+(hash-rehash) Inserted 1000 elements, checking them mid-rehash.
+(hash-rehash) Deleted all but 10 elements, checking them mid-rehash.
+(hash-rehash) end
+EOF
+pass;
@@ -0,0 +1,86 @@
+/* Runs the same malloc()/free() workload on several kernel
+   threads at once, first with the per-thread magazines turned
+   off, so that every call takes its size class's lock, and then
+   with them on, and reports how long each run took.
+
+   Each thread fills every block it gets and checks the pattern
+   before freeing it, so blocks handed to two threads at once
+   show up as failures. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define ITER_CNT 2000
+#define LIVE_CNT 4
+
+static struct semaphore done;
+
+static void
+bench_thread (void *aux)
+{
+  uint8_t id = (uintptr_t) aux;
+  uint8_t *live[LIVE_CNT] = { NULL };
+  size_t sizes[LIVE_CNT];
+  int i, j;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      int slot = i % LIVE_CNT;
+      size_t size = 16 << (i % 6);
+
+      if (live[slot] != NULL)
+        {
+          for (j = 0; j < (int) sizes[slot]; j++)
+            if (live[slot][j] != id)
+              fail ("thread %d: block %p corrupted", id, live[slot]);
+          free (live[slot]);
+        }
+
+      live[slot] = malloc (size);
+      if (live[slot] == NULL)
+        fail ("thread %d: out of memory", id);
+      sizes[slot] = size;
+      for (j = 0; j < (int) size; j++)
+        live[slot][j] = id;
+    }
+
+  for (i = 0; i < LIVE_CNT; i++)
+    free (live[i]);
+  sema_up (&done);
+}
+
+/* Runs the workload with magazines on or off and returns the
+   number of microseconds it took. */
+static uint64_t
+run (bool magazines)
+{
+  uint64_t start;
+  int i;
+
+  malloc_use_magazines = magazines;
+  sema_init (&done, 0);
+  start = timer_now_ns ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "bench %d", i);
+      thread_create (name, PRI_DEFAULT, bench_thread, (void *) (uintptr_t) i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  return (timer_now_ns () - start) / 1000;
+}
+
+void
+test_malloc_bench (void) 
+{
+  msg ("%d threads, %d malloc/free pairs each.", THREAD_CNT, ITER_CNT);
+  msg ("magazines off: %llu us", run (false));
+  msg ("magazines on: %llu us", run (true));
+  pass ();
+}
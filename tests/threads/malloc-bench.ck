@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $mode ('off', 'on') {
+    fail "missing timing for magazines $mode\n"
+      if !grep (/^\(malloc-bench\) magazines $mode: \d+ us$/, @output);
+}
+fail "missing PASS\n" if !grep (/^\(malloc-bench\) PASS$/, @output);
+pass;
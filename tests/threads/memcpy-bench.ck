@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $op ('memcpy', 'memset', 'memcmp') {
+    foreach my $name ("byte $op", $op) {
+	fail "missing throughput for $name\n"
+	  if !grep (/^\(memcpy-bench\) $name: \d+ MB\/s$/, @output);
+    }
+}
+fail "missing PASS\n" if !grep (/^\(memcpy-bench\) PASS$/, @output);
+pass;
@@ -13,7 +13,15 @@
    They should receive 672, 588, 492, 408, 316, 232, 152, 92, 40,
    and 8 ticks, respectively, over 30 seconds.
 
-   (The above are computed via simulation in mlfqs.pm.) */
+   (The above are computed via simulation in mlfqs.pm.)
+
+   The cfs-* tests run the same loads under the completely fair
+   scheduler, which should split the ticks in proportion to each
+   nice value's load weight instead: about 2,260 and 740 ticks for
+   nice 0 and 5, for example.  Comparing the two sets of results
+   shows how closely each scheduler tracks its ideal shares.  The
+   fair tests also report Jain's fairness index, which is 1000
+   when all threads got exactly the same number of ticks. */
 
 #include <stdio.h>
 #include <inttypes.h>
@@ -51,6 +59,30 @@ test_mlfqs_nice_10 (void)
   test_mlfqs_fair (10, 0, 1);
 }
 
+void
+test_cfs_fair_2 (void) 
+{
+  test_mlfqs_fair (2, 0, 0);
+}
+
+void
+test_cfs_fair_20 (void) 
+{
+  test_mlfqs_fair (20, 0, 0);
+}
+
+void
+test_cfs_nice_2 (void) 
+{
+  test_mlfqs_fair (2, 0, 5);
+}
+
+void
+test_cfs_nice_10 (void) 
+{
+  test_mlfqs_fair (10, 0, 1);
+}
+
 #define MAX_THREAD_CNT 20
 
 struct thread_info 
@@ -70,7 +102,7 @@ test_mlfqs_fair (int thread_cnt, int nice_min, int nice_step)
   int nice;
   int i;
 
-  ASSERT (thread_mlfqs);
+  ASSERT (thread_mlfqs || thread_cfs);
   ASSERT (thread_cnt <= MAX_THREAD_CNT);
   ASSERT (nice_min >= -10);
   ASSERT (nice_step >= 0);
@@ -102,6 +134,20 @@ test_mlfqs_fair (int thread_cnt, int nice_min, int nice_step)
   
   for (i = 0; i < thread_cnt; i++)
     msg ("Thread %d received %d ticks.", i, info[i].tick_count);
+
+  if (nice_step == 0)
+    {
+      int64_t sum = 0, sum_sq = 0;
+
+      for (i = 0; i < thread_cnt; i++)
+        {
+          sum += info[i].tick_count;
+          sum_sq += (int64_t) info[i].tick_count * info[i].tick_count;
+        }
+      if (sum_sq > 0)
+        msg ("Fairness index: %"PRId64"/1000.",
+             sum * sum * 1000 / (thread_cnt * sum_sq));
+    }
 }
 
 static void
@@ -0,0 +1,158 @@
+/* Tests the open-addressing hash table across its incremental
+   resizes.  Every element stays findable while the table grows,
+   iterating in the middle of a resize visits each element
+   exactly once, and deleting half the elements, some of them
+   while a resize is in flight, leaves exactly the other half. */
+
+#include <hash.h>
+#include <ohash.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+
+#define ELEM_CNT 1000
+
+struct item
+  {
+    struct ohash_elem elem;
+    int key;
+  };
+
+static struct item items[ELEM_CNT];
+static bool seen[ELEM_CNT];
+
+static uint64_t
+item_hash (const struct ohash_elem *e, void *aux UNUSED)
+{
+  return hash_int (ohash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct ohash_elem *a, const struct ohash_elem *b,
+           void *aux UNUSED)
+{
+  return (ohash_entry (a, struct item, elem)->key
+          < ohash_entry (b, struct item, elem)->key);
+}
+
+/* Returns the item in H with KEY, or a null pointer. */
+static struct item *
+find (struct ohash *h, int key)
+{
+  struct item probe;
+  struct ohash_elem *e;
+
+  probe.key = key;
+  e = ohash_find (h, &probe.elem);
+  return e != NULL ? ohash_entry (e, struct item, elem) : NULL;
+}
+
+/* Iterates over H and fails unless it visits every element once,
+   and only the elements, in ITEMS that PRESENT says are there. */
+static void
+check_iteration (struct ohash *h, bool (*present) (int key))
+{
+  struct ohash_iterator i;
+  size_t cnt = 0;
+  int key;
+
+  memset (seen, 0, sizeof seen);
+  ohash_first (&i, h);
+  while (ohash_next (&i))
+    {
+      struct item *it = ohash_entry (ohash_cur (&i), struct item, elem);
+
+      if (it != &items[it->key] || !present (it->key))
+        fail ("iteration visited stray element %d", it->key);
+      if (seen[it->key])
+        fail ("iteration visited element %d twice", it->key);
+      seen[it->key] = true;
+      cnt++;
+    }
+  if (cnt != ohash_size (h))
+    fail ("iteration visited %zu elements of %zu", cnt, ohash_size (h));
+  for (key = 0; key < ELEM_CNT; key++)
+    if (present (key) && !seen[key])
+      fail ("iteration missed element %d", key);
+}
+
+/* Number of elements inserted so far. */
+static int inserted;
+
+static bool
+is_inserted (int key)
+{
+  return key < inserted;
+}
+
+static bool
+is_odd (int key)
+{
+  return key % 2 != 0;
+}
+
+void
+test_ohash_resize (void)
+{
+  struct ohash h;
+  int mid_resize = 0;
+  int key;
+
+  if (!ohash_init (&h, item_hash, item_less, NULL))
+    fail ("ohash_init failed");
+
+  /* Insert, checking everything inserted so far after each
+     insertion that leaves a resize in flight. */
+  for (inserted = 0; inserted < ELEM_CNT; )
+    {
+      items[inserted].key = inserted;
+      if (ohash_insert (&h, &items[inserted].elem) != NULL)
+        fail ("inserting element %d failed", inserted);
+      inserted++;
+
+      if (h.old.slots != NULL)
+        {
+          mid_resize++;
+          for (key = 0; key < inserted; key++)
+            if (find (&h, key) != &items[key])
+              fail ("element %d lost after %d insertions", key, inserted);
+          check_iteration (&h, is_inserted);
+        }
+    }
+  if (mid_resize == 0)
+    fail ("no insertion left a resize in flight");
+  if (ohash_size (&h) != ELEM_CNT)
+    fail ("table holds %zu elements instead of %d",
+          ohash_size (&h), ELEM_CNT);
+  msg ("Inserted %d elements, checking them mid-resize.", ELEM_CNT);
+
+  /* Equal elements are refused. */
+  {
+    struct item dup;
+
+    dup.key = ELEM_CNT / 2;
+    if (ohash_insert (&h, &dup.elem) != &items[ELEM_CNT / 2].elem)
+      fail ("duplicate insertion did not return the existing element");
+  }
+
+  /* Delete the even elements.  Deletions move a resize still in
+     flight along, just as insertions do. */
+  for (key = 0; key < ELEM_CNT; key += 2)
+    {
+      struct item probe;
+
+      probe.key = key;
+      if (ohash_delete (&h, &probe.elem) != &items[key].elem)
+        fail ("deleting element %d failed", key);
+      if (find (&h, key) != NULL)
+        fail ("element %d found after deletion", key);
+    }
+  for (key = 0; key < ELEM_CNT; key++)
+    if ((find (&h, key) != NULL) != is_odd (key))
+      fail ("element %d is in the wrong state after deletions", key);
+  check_iteration (&h, is_odd);
+  msg ("Deleted every other element.");
+
+  ohash_destroy (&h, NULL);
+}
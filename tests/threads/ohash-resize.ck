@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ohash-resize) begin
+(ohash-resize) Inserted 1000 elements, checking them mid-resize.
+(ohash-resize) Deleted every other element.
+(ohash-resize) end
+EOF
+pass;
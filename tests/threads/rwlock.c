@@ -0,0 +1,71 @@
+/* Tests reader-writer locks.  Readers share the lock, a waiting
+   writer holds off readers that arrive after it, and a reader
+   waiting behind the writer donates its priority to the writer.
+   Also checks the try-variants. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread, writer_thread;
+static struct rwlock rwlock;
+
+void
+test_rwlock (void) 
+{
+  /* This test does not work with the MLFQS or the fair scheduler. */
+  ASSERT (!thread_mlfqs && !thread_cfs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+  rwlock_acquire_read (&rwlock);
+
+  /* Other readers get in alongside us. */
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread, "reader 1");
+  thread_create ("reader 2", PRI_DEFAULT + 1, reader_thread, "reader 2");
+
+  /* The writer has to wait for us, and the late reader for it. */
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread, NULL);
+  thread_create ("late reader", PRI_DEFAULT + 2, reader_thread,
+                 "late reader");
+
+  msg ("Releasing the read lock.");
+  rwlock_release_read (&rwlock);
+  msg ("Back in main thread.");
+
+  if (!rwlock_try_acquire_write (&rwlock))
+    fail ("try_acquire_write failed on a free lock");
+  if (!rwlock_held_for_write (&rwlock))
+    fail ("write lock not held after try_acquire_write");
+  if (rwlock_try_acquire_read (&rwlock))
+    fail ("try_acquire_read succeeded against a writer");
+  rwlock_release_write (&rwlock);
+
+  if (!rwlock_try_acquire_read (&rwlock))
+    fail ("try_acquire_read failed on a free lock");
+  if (rwlock_try_acquire_write (&rwlock))
+    fail ("try_acquire_write succeeded against a reader");
+  rwlock_release_read (&rwlock);
+  msg ("Try-variants work.");
+}
+
+static void
+reader_thread (void *name) 
+{
+  rwlock_acquire_read (&rwlock);
+  msg ("%s got the lock.", (const char *) name);
+  rwlock_release_read (&rwlock);
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  rwlock_acquire_write (&rwlock);
+  msg ("writer got the lock at priority %d.", thread_get_priority ());
+  rwlock_release_write (&rwlock);
+  msg ("writer done at priority %d.", thread_get_priority ());
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock) begin
+(rwlock) reader 1 got the lock.
+(rwlock) reader 2 got the lock.
+(rwlock) Releasing the read lock.
+(rwlock) writer got the lock at priority 33.
+(rwlock) late reader got the lock.
+(rwlock) writer done at priority 32.
+(rwlock) Back in main thread.
+(rwlock) Try-variants work.
+(rwlock) end
+EOF
+pass;
@@ -0,0 +1,207 @@
+/* Checks strlen(), strchr(), strcmp() and strlcpy(), which scan
+   a word at a time, against plain byte-at-a-time loops.  Every
+   string ends with its null in the last byte of a page whose
+   next page is unmapped, so a load that strays past the string
+   into the next page faults, and the strings start at every
+   alignment. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Longest string tried.  Long enough for several words at every
+   alignment. */
+#define MAX_LEN 40
+
+/* Pages in use: three strings' pages, each followed by an
+   unmapped guard page. */
+#define PAGE_CNT 6
+
+static size_t
+byte_strlen (const char *s)
+{
+  size_t len = 0;
+
+  while (s[len] != '\0')
+    len++;
+  return len;
+}
+
+static char *
+byte_strchr (const char *s, int c_)
+{
+  char c = c_;
+
+  for (;; s++)
+    if (*s == c)
+      return (char *) s;
+    else if (*s == '\0')
+      return NULL;
+}
+
+static int
+byte_strcmp (const char *a_, const char *b_)
+{
+  const unsigned char *a = (const unsigned char *) a_;
+  const unsigned char *b = (const unsigned char *) b_;
+
+  while (*a != '\0' && *a == *b)
+    {
+      a++;
+      b++;
+    }
+  return *a < *b ? -1 : *a > *b;
+}
+
+static size_t
+byte_strlcpy (char *dst, const char *src, size_t size)
+{
+  size_t len = byte_strlen (src);
+
+  if (size > 0)
+    {
+      size_t i;
+
+      for (i = 0; i < size - 1 && i < len; i++)
+        dst[i] = src[i];
+      dst[i] = '\0';
+    }
+  return len;
+}
+
+/* Marks the page at kernel address PAGE present or not. */
+static void
+set_present (void *page, bool present)
+{
+  uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) page, false);
+
+  ASSERT (pte != NULL);
+  if (present)
+    *pte |= PTE_P;
+  else
+    *pte &= ~(uint64_t) PTE_P;
+  invlpg ((uint64_t) page);
+}
+
+/* Returns the sign of X. */
+static int
+sign (int x)
+{
+  return x < 0 ? -1 : x > 0;
+}
+
+/* Writes a string of LEN nonzero bytes, including ones with the
+   high bit set, so that its null is the last byte of PAGE, and
+   returns its start. */
+static char *
+put_string (uint8_t *page, size_t len)
+{
+  char *s = (char *) page + PGSIZE - 1 - len;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    s[i] = i * 37 % 255 + 1;
+  s[len] = '\0';
+  return s;
+}
+
+static void
+check_strlen_strchr (uint8_t *page)
+{
+  size_t len, i;
+
+  for (len = 0; len <= MAX_LEN; len++)
+    {
+      char *s = put_string (page, len);
+
+      if (strlen (s) != len)
+        fail ("strlen of %zu bytes returned %zu", len, strlen (s));
+
+      /* Each byte of the string, the null, and one that is not
+         in it. */
+      for (i = 0; i <= len; i++)
+        if (strchr (s, s[i]) != byte_strchr (s, s[i]))
+          fail ("strchr of %zu bytes missed byte %zu", len, i);
+      if (strchr (s, 0xff) != byte_strchr (s, 0xff))
+        fail ("strchr of %zu bytes found an absent byte", len);
+    }
+}
+
+static void
+check_strcmp (uint8_t *page_a, uint8_t *page_b)
+{
+  size_t la, lb;
+  int d;
+
+  for (la = 0; la <= MAX_LEN; la++)
+    for (lb = 0; lb <= MAX_LEN; lb++)
+      /* D < 0 leaves the common prefix equal; otherwise B differs
+         from A at byte D. */
+      for (d = -1; d < (int) lb; d += lb / 3 + 1)
+        {
+          char *a = put_string (page_a, la);
+          char *b = put_string (page_b, lb);
+
+          if (d >= 0)
+            b[d] = b[d] == (char) 0xff ? 1 : b[d] + 1;
+          if (sign (strcmp (a, b)) != byte_strcmp (a, b)
+              || sign (strcmp (b, a)) != byte_strcmp (b, a))
+            fail ("strcmp of %zu and %zu bytes differing at %d",
+                  la, lb, d);
+        }
+}
+
+static void
+check_strlcpy (uint8_t *page_src, uint8_t *page_dst)
+{
+  static char expect[MAX_LEN + 16];
+  size_t len, size, i;
+
+  for (len = 0; len <= MAX_LEN; len++)
+    for (size = 0; size <= len + 9; size++)
+      {
+        char *src = put_string (page_src, len);
+        /* DST ends at the end of its page as well. */
+        char *dst = (char *) page_dst + PGSIZE - size;
+
+        for (i = 0; i < size; i++)
+          dst[i] = expect[i] = 0xcc;
+        if (strlcpy (dst, src, size) != len)
+          fail ("strlcpy of %zu bytes into %zu returned the wrong length",
+                len, size);
+        byte_strlcpy (expect, src, size);
+        for (i = 0; i < size; i++)
+          if (dst[i] != expect[i])
+            fail ("strlcpy of %zu bytes into %zu wrong at byte %zu",
+                  len, size, i);
+      }
+}
+
+void
+test_string_bounds (void) 
+{
+  uint8_t *pages = palloc_get_multiple (0, PAGE_CNT);
+  int i;
+
+  if (pages == NULL)
+    fail ("out of pages");
+  for (i = 1; i < PAGE_CNT; i += 2)
+    set_present (pages + i * PGSIZE, false);
+
+  check_strlen_strchr (pages);
+  msg ("strlen and strchr match byte loops.");
+  check_strcmp (pages, pages + 2 * PGSIZE);
+  msg ("strcmp matches a byte loop.");
+  check_strlcpy (pages, pages + 4 * PGSIZE);
+  msg ("strlcpy matches a byte loop.");
+
+  for (i = 1; i < PAGE_CNT; i += 2)
+    set_present (pages + i * PGSIZE, true);
+  palloc_free_multiple (pages, PAGE_CNT);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(string-bounds) begin
+(string-bounds) strlen and strchr match byte loops.
+(string-bounds) strcmp matches a byte loop.
+(string-bounds) strlcpy matches a byte loop.
+(string-bounds) end
+EOF
+pass;
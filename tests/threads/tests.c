@@ -29,6 +29,14 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"malloc-bench", test_malloc_bench},
+    {"memcpy-bench", test_memcpy_bench},
+    {"string-bounds", test_string_bounds},
+    {"rwlock", test_rwlock},
+    {"workqueue", test_workqueue},
+    {"ohash-resize", test_ohash_resize},
+    {"hash-rehash", test_hash_rehash},
+    {"alarm-tickless", test_alarm_tickless},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -38,6 +46,10 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"cfs-fair-2", test_cfs_fair_2},
+    {"cfs-fair-20", test_cfs_fair_20},
+    {"cfs-nice-2", test_cfs_nice_2},
+    {"cfs-nice-10", test_cfs_nice_10},
   };
 
 static const char *test_name;
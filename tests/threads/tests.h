@@ -23,6 +23,14 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_malloc_bench;
+extern test_func test_memcpy_bench;
+extern test_func test_string_bounds;
+extern test_func test_rwlock;
+extern test_func test_workqueue;
+extern test_func test_ohash_resize;
+extern test_func test_hash_rehash;
+extern test_func test_alarm_tickless;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -32,6 +40,10 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_cfs_fair_2;
+extern test_func test_cfs_fair_20;
+extern test_func test_cfs_nice_2;
+extern test_func test_cfs_nice_10;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,126 @@
+/* Tests kernel workqueues.  A queue limited to one item at a
+   time runs its items in order, a queue limited to 3 never runs
+   more than 3 at once, a delayed item waits out its delay, and
+   queued items can be canceled. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define ITEM_CNT 6
+
+struct item
+  {
+    struct work work;
+    int id;
+  };
+
+static struct item items[ITEM_CNT];
+
+/* Running items and the most seen at once. */
+static int running, max_running;
+
+/* Order in which items ran. */
+static int order[ITEM_CNT];
+static int order_cnt;
+
+static void
+item_func (void *aux)
+{
+  struct item *item = aux;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  order[order_cnt++] = item->id;
+  if (++running > max_running)
+    max_running = running;
+  intr_set_level (old_level);
+
+  timer_sleep (5);
+
+  old_level = intr_disable ();
+  running--;
+  intr_set_level (old_level);
+}
+
+/* Queues ITEM_CNT items on a queue that allows MAX_ACTIVE at
+   once, waits for them, and returns the most that ran at
+   once. */
+static int
+run_items (const char *name, int max_active)
+{
+  struct workqueue wq;
+  int i;
+
+  workqueue_init (&wq, name, max_active);
+  running = max_running = order_cnt = 0;
+  for (i = 0; i < ITEM_CNT; i++)
+    {
+      items[i].id = i;
+      work_init (&items[i].work, item_func, &items[i]);
+      if (!queue_work (&wq, &items[i].work))
+        fail ("item %d was not queued", i);
+    }
+  if (queue_work (&wq, &items[ITEM_CNT - 1].work))
+    fail ("item queued twice");
+  workqueue_flush (&wq);
+
+  if (order_cnt != ITEM_CNT)
+    fail ("%d items ran instead of %d", order_cnt, ITEM_CNT);
+  return max_running;
+}
+
+static struct semaphore delayed_done;
+static int64_t delayed_ran;
+
+static void
+delayed_func (void *aux UNUSED)
+{
+  delayed_ran = timer_ticks ();
+  sema_up (&delayed_done);
+}
+
+void
+test_workqueue (void)
+{
+  struct work delayed, canceled;
+  int64_t start;
+  int i;
+
+  /* One at a time, in order. */
+  if (run_items ("serial", 1) != 1)
+    fail ("serial queue ran items at the same time");
+  for (i = 0; i < ITEM_CNT; i++)
+    if (order[i] != i)
+      fail ("serial queue ran item %d in place %d", order[i], i);
+  msg ("Serial queue ran %d items in order.", ITEM_CNT);
+
+  /* At most 3 at once. */
+  msg ("Limited queue ran at most %d items at once.",
+       run_items ("limited", 3));
+
+  /* A delayed item waits out its delay. */
+  sema_init (&delayed_done, 0);
+  work_init (&delayed, delayed_func, NULL);
+  start = timer_ticks ();
+  queue_delayed_work (&system_wq, &delayed, 20);
+  sema_down (&delayed_done);
+  if (delayed_ran - start < 20)
+    fail ("delayed item ran after %"PRId64" ticks", delayed_ran - start);
+  msg ("Delayed item ran after at least 20 ticks.");
+
+  /* Canceling. */
+  work_init (&canceled, delayed_func, NULL);
+  queue_delayed_work (&system_wq, &canceled, 1000);
+  if (!cancel_work (&canceled))
+    fail ("could not cancel delayed item");
+  if (cancel_work (&canceled))
+    fail ("canceled item twice");
+  msg ("Canceled a delayed item.");
+}
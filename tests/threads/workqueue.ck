@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Serial queue ran 6 items in order.
+(workqueue) Limited queue ran at most 3 items at once.
+(workqueue) Delayed item ran after at least 20 ticks.
+(workqueue) Canceled a delayed item.
+(workqueue) end
+EOF
+pass;
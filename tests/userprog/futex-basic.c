@@ -0,0 +1,21 @@
+/* Exercises the futex() paths a single thread can reach: waiting
+   on a value that has already changed returns at once, waking a
+   futex nobody sleeps on wakes no one, and a misaligned address
+   or an unknown operation is refused. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 1;
+
+void
+test_main (void) 
+{
+  CHECK (futex (&word, FUTEX_WAIT, 0) == -1, "wait on stale value");
+  CHECK (futex (&word, FUTEX_WAKE, 1) == 0, "wake with no sleepers");
+  CHECK (futex ((int *) ((char *) &word + 1), FUTEX_WAKE, 1) == -1,
+         "misaligned futex");
+  CHECK (futex (&word, 42, 0) == -1, "unknown operation");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-basic) begin
+(futex-basic) wait on stale value
+(futex-basic) wake with no sleepers
+(futex-basic) misaligned futex
+(futex-basic) unknown operation
+(futex-basic) end
+futex-basic: exit(0)
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Puts several threads of one process to sleep on a futex and
+   wakes them one at a time.  Each FUTEX_WAKE wakes at most the
+   number of threads asked for, and only threads that were really
+   asleep, so the wakes add up to exactly the number of
+   sleepers. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 3
+#define STACK_SIZE 4096
+
+static char stacks[THREAD_CNT][STACK_SIZE] __attribute__ ((aligned (16)));
+static int word;
+static int results[THREAD_CNT];
+
+static void
+sleeper (void *aux)
+{
+  int idx = (long) aux;
+
+  results[idx] = futex (&word, FUTEX_WAIT, 0);
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  int woken = 0;
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      results[i] = 1;
+      tids[i] = uthread_create (sleeper, (void *) (long) i,
+                                stacks[i] + STACK_SIZE);
+      if (tids[i] == TID_ERROR)
+        fail ("uthread_create() failed");
+    }
+
+  /* A wake finds no one until a sleeper gets to futex(). */
+  while (woken < THREAD_CNT)
+    {
+      int n = futex (&word, FUTEX_WAKE, 1);
+      if (n < 0 || n > 1)
+        fail ("FUTEX_WAKE of 1 woke %d threads", n);
+      woken += n;
+    }
+  msg ("woke %d sleepers one at a time", THREAD_CNT);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      if (uthread_join (tids[i]) != 0)
+        fail ("uthread_join() failed");
+      if (results[i] != 0)
+        fail ("sleeper %d's FUTEX_WAIT returned %d", i, results[i]);
+    }
+  msg ("every sleeper returned from FUTEX_WAIT");
+
+  CHECK (futex (&word, FUTEX_WAKE, THREAD_CNT) == 0, "no sleepers left");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-wake) begin
+(futex-wake) woke 3 sleepers one at a time
+(futex-wake) every sleeper returned from FUTEX_WAIT
+(futex-wake) no sleepers left
+(futex-wake) end
+futex-wake: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* The child moves the write end of a pipe onto its standard
+   output and prints through it; the parent reads what it
+   printed.  The parent only sees end of stream if the child's
+   descriptor 1 is closed when it exits. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t ofs = 0;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  if ((pid = fork ("child")) == 0)
+    {
+      /* Nothing may be printed to the console from here on. */
+      if (dup2 (fds[1], STDOUT_FILENO) != STDOUT_FILENO)
+        exit (1);
+      close (fds[0]);
+      close (fds[1]);
+      if (write (STDOUT_FILENO, sample, sizeof sample - 1)
+          != sizeof sample - 1)
+        exit (2);
+      exit (0);
+    }
+
+  close (fds[1]);
+  while ((n = read (fds[0], buf + ofs, sizeof buf - ofs)) > 0)
+    ofs += n;
+  if (n < 0)
+    fail ("read() from pipe failed");
+  if (ofs != sizeof sample - 1)
+    fail ("read %zu bytes from pipe instead of %zu", ofs, sizeof sample - 1);
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "pipe");
+  msg ("end of stream");
+
+  CHECK (wait (pid) == 0, "wait for child");
+  close (fds[0]);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-dup2) begin
+(pipe-dup2) pipe
+child: exit(0)
+(pipe-dup2) end of stream
+(pipe-dup2) wait for child
+(pipe-dup2) end
+pipe-dup2: exit(0)
+EOF
+pass;
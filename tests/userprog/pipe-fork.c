@@ -0,0 +1,40 @@
+/* The child writes "sample.txt" into a pipe and exits; the parent
+   reads it back until end of stream. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t ofs = 0;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  if ((pid = fork ("child")) == 0)
+    {
+      close (fds[0]);
+      if (write (fds[1], sample, sizeof sample - 1) != sizeof sample - 1)
+        fail ("write() to pipe failed");
+      exit (0);
+    }
+
+  close (fds[1]);
+  while ((n = read (fds[0], buf + ofs, sizeof buf - ofs)) > 0)
+    ofs += n;
+  if (n < 0)
+    fail ("read() from pipe failed");
+  if (ofs != sizeof sample - 1)
+    fail ("read %zu bytes from pipe instead of %zu", ofs, sizeof sample - 1);
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "pipe");
+  msg ("end of stream");
+
+  wait (pid);
+  close (fds[0]);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-fork) begin
+(pipe-fork) pipe
+child: exit(0)
+(pipe-fork) end of stream
+(pipe-fork) end
+pipe-fork: exit(0)
+EOF
+pass;
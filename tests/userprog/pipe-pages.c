@@ -0,0 +1,51 @@
+/* The child writes several pages into a pipe in one write(),
+   more than the pipe can buffer at once; the parent reads them
+   back a page at a time into a page-aligned buffer and checks
+   every byte. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 6
+
+static char out[PAGE_SIZE * PAGE_CNT] __attribute__ ((aligned (PAGE_SIZE)));
+static char in[PAGE_SIZE * PAGE_CNT] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void) 
+{
+  size_t ofs = 0;
+  size_t i;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  for (i = 0; i < sizeof out; i++)
+    out[i] = i * 7 + i / PAGE_SIZE;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  if ((pid = fork ("child")) == 0)
+    {
+      close (fds[0]);
+      if (write (fds[1], out, sizeof out) != sizeof out)
+        fail ("write() to pipe failed");
+      exit (0);
+    }
+
+  close (fds[1]);
+  while (ofs < sizeof in
+         && (n = read (fds[0], in + ofs, PAGE_SIZE)) > 0)
+    ofs += n;
+  if (read (fds[0], in, PAGE_SIZE) != 0)
+    fail ("no end of stream after %zu bytes", ofs);
+  if (ofs != sizeof in)
+    fail ("read %zu bytes from pipe instead of %zu", ofs, sizeof in);
+  compare_bytes (in, out, sizeof in, 0, "pipe");
+  msg ("end of stream");
+
+  wait (pid);
+  close (fds[0]);
+}
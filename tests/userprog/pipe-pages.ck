@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-pages) begin
+(pipe-pages) pipe
+child: exit(0)
+(pipe-pages) end of stream
+(pipe-pages) end
+pipe-pages: exit(0)
+EOF
+pass;
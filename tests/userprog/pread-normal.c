@@ -0,0 +1,26 @@
+/* Reads "sample.txt" back to front with pread() and checks that
+   the file position is left alone. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t half = (sizeof sample - 1) / 2;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  if (pread (handle, buf + half, sizeof sample - 1 - half, half)
+      != (int) (sizeof sample - 1 - half))
+    fail ("pread() of second half failed");
+  if (pread (handle, buf, half, 0) != (int) half)
+    fail ("pread() of first half failed");
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+
+  CHECK (tell (handle) == 0, "file position unchanged");
+}
@@ -0,0 +1,168 @@
+/* Writes the same stream of small records to two files, once
+   with one write() per record and once in batches through a
+   submission ring, then reads the batched file back through the
+   ring and checks that both files match.  The number of kernel
+   entries each way is reported, and then both ways of writing
+   are timed over several rounds and the two tick counts
+   reported. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RECORD_SIZE 16
+#define RECORD_CNT 512
+
+/* Rounds of RECORD_CNT writes timed each way. */
+#define TIMED_ROUNDS 16
+
+static struct ring ring;
+static char records[RECORD_CNT][RECORD_SIZE];
+static char readback[RECORD_CNT][RECORD_SIZE];
+
+/* Queues one entry on the ring, submitting the ring first if it
+   is full.  Returns the number of ring_submit() calls made. */
+static int
+queue (int op, int fd, void *buf, unsigned len, uint64_t user_data)
+{
+  int calls = 0;
+  struct ring_sqe *sqe;
+
+  if (ring.sq_tail - ring.sq_head == RING_ENTRIES)
+    {
+      ring_submit (RING_ENTRIES);
+      calls++;
+    }
+  sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->user_data = user_data;
+  ring.sq_tail++;
+  return calls;
+}
+
+/* Reaps every posted completion, failing on a short transfer. */
+static void
+reap (void)
+{
+  while (ring.cq_head != ring.cq_tail)
+    {
+      struct ring_cqe *cqe = &ring.cq[ring.cq_head % RING_ENTRIES];
+      if (cqe->res != RECORD_SIZE)
+        fail ("record %llu returned %d", cqe->user_data, cqe->res);
+      ring.cq_head++;
+    }
+}
+
+/* Queues RECORD_CNT transfers of OP on FD and runs them all.
+   Returns the number of ring_submit() calls made. */
+static int
+batch (int op, int fd, char (*buf)[RECORD_SIZE])
+{
+  int calls = 0;
+  int i;
+
+  for (i = 0; i < RECORD_CNT; i++)
+    {
+      calls += queue (op, fd, buf[i], RECORD_SIZE, i);
+      reap ();
+    }
+  while (ring.sq_head != ring.sq_tail)
+    {
+      ring_submit (RING_ENTRIES);
+      calls++;
+      reap ();
+    }
+  return calls;
+}
+
+/* Rewinds FD to its start through the ring and discards the
+   completion. */
+static void
+rewind (int fd)
+{
+  queue (RING_OP_SEEK, fd, NULL, 0, 0);
+  ring_submit (1);
+  ring.cq_head = ring.cq_tail;
+}
+
+/* Rewrites "single" TIMED_ROUNDS times with one write() per
+   record and returns the ticks it took. */
+static int64_t
+time_single (int fd)
+{
+  int64_t start = vdso_ticks ();
+  int round, i;
+
+  for (round = 0; round < TIMED_ROUNDS; round++)
+    {
+      seek (fd, 0);
+      for (i = 0; i < RECORD_CNT; i++)
+        if (write (fd, records[i], RECORD_SIZE) != RECORD_SIZE)
+          fail ("write() of record %d failed", i);
+    }
+  return vdso_ticks () - start;
+}
+
+/* Rewrites "batched" TIMED_ROUNDS times through the ring and
+   returns the ticks it took. */
+static int64_t
+time_batched (int fd)
+{
+  int64_t start = vdso_ticks ();
+  int round;
+
+  for (round = 0; round < TIMED_ROUNDS; round++)
+    {
+      rewind (fd);
+      batch (RING_OP_WRITE, fd, records);
+    }
+  return vdso_ticks () - start;
+}
+
+void
+test_main (void)
+{
+  int single_fd, batch_fd;
+  int calls;
+  int i;
+
+  for (i = 0; i < RECORD_CNT; i++)
+    snprintf (records[i], RECORD_SIZE, "record %7d\n", i);
+
+  CHECK (create ("single", 0), "create \"single\"");
+  CHECK (create ("batched", 0), "create \"batched\"");
+  CHECK ((single_fd = open ("single")) > 1, "open \"single\"");
+  CHECK ((batch_fd = open ("batched")) > 1, "open \"batched\"");
+  CHECK (ring_setup (&ring) == 0, "ring_setup");
+
+  for (i = 0; i < RECORD_CNT; i++)
+    if (write (single_fd, records[i], RECORD_SIZE) != RECORD_SIZE)
+      fail ("write() of record %d failed", i);
+  msg ("per-call writes: %d system calls", RECORD_CNT);
+
+  calls = batch (RING_OP_WRITE, batch_fd, records);
+  msg ("batched writes: %d system calls", calls);
+
+  rewind (batch_fd);
+  calls = batch (RING_OP_READ, batch_fd, readback);
+  msg ("batched reads: %d system calls", calls);
+  compare_bytes (readback, records, sizeof records, 0, "batched");
+
+  seek (single_fd, 0);
+  if (read (single_fd, readback, sizeof readback) != sizeof readback)
+    fail ("read() of \"single\" came up short");
+  compare_bytes (readback, records, sizeof records, 0, "single");
+
+  msg ("per-call writes: %lld ticks for %d rounds",
+       (long long) time_single (single_fd), TIMED_ROUNDS);
+  msg ("batched writes: %lld ticks for %d rounds",
+       (long long) time_batched (batch_fd), TIMED_ROUNDS);
+
+  queue (RING_OP_CLOSE, single_fd, NULL, 0, 0);
+  queue (RING_OP_CLOSE, batch_fd, NULL, 0, 1);
+  CHECK (ring_submit (RING_ENTRIES) == 2, "close both files through the ring");
+}
@@ -0,0 +1,32 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The timings vary from run to run, so check their form and
+# compare the rest of the output exactly.
+foreach my $way ('per-call', 'batched') {
+    fail "missing timing for $way writes\n"
+      if !grep (/^\(ring-batch\) $way writes: \d+ ticks for \d+ rounds$/,
+                @output);
+}
+@output = grep (!/^\(ring-batch\) [a-z-]+ writes: \d+ ticks/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(ring-batch) begin
+(ring-batch) create "single"
+(ring-batch) create "batched"
+(ring-batch) open "single"
+(ring-batch) open "batched"
+(ring-batch) ring_setup
+(ring-batch) per-call writes: 512 system calls
+(ring-batch) batched writes: 8 system calls
+(ring-batch) batched reads: 8 system calls
+(ring-batch) close both files through the ring
+(ring-batch) end
+ring-batch: exit(0)
+EOF
+pass;
@@ -0,0 +1,76 @@
+/* Runs several threads in one process.  They share its memory:
+   each sums part of a common array, and one hands a value to the
+   main thread through a futex.  Joining waits for each thread,
+   and a thread cannot be joined twice. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ELEM_CNT 4096
+#define STACK_SIZE 4096
+
+static int array[ELEM_CNT];
+static int sums[THREAD_CNT];
+static char stacks[THREAD_CNT + 1][STACK_SIZE] __attribute__ ((aligned (16)));
+static int handoff;
+
+static void
+summer (void *aux)
+{
+  int idx = (long) aux;
+  int i;
+
+  for (i = idx; i < ELEM_CNT; i += THREAD_CNT)
+    sums[idx] += array[i];
+}
+
+static void
+giver (void *aux UNUSED)
+{
+  handoff = 42;
+  futex (&handoff, FUTEX_WAKE, 1);
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT], tid;
+  int sum = 0;
+  int i;
+
+  for (i = 0; i < ELEM_CNT; i++)
+    array[i] = i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      tids[i] = uthread_create (summer, (void *) (long) i,
+                                stacks[i] + STACK_SIZE);
+      if (tids[i] == TID_ERROR)
+        fail ("uthread_create() failed");
+    }
+  msg ("started %d threads", THREAD_CNT);
+
+  tid = uthread_create (giver, NULL, stacks[THREAD_CNT] + STACK_SIZE);
+  if (tid == TID_ERROR)
+    fail ("uthread_create() failed");
+  while (handoff == 0)
+    futex (&handoff, FUTEX_WAIT, 0);
+  msg ("got %d through a futex", handoff);
+  CHECK (uthread_join (tid) == 0, "join giver");
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (uthread_join (tids[i]) != 0)
+      fail ("uthread_join() failed");
+  msg ("joined %d threads", THREAD_CNT);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sum += sums[i];
+  if (sum != ELEM_CNT * (ELEM_CNT - 1) / 2)
+    fail ("sum is %d instead of %d", sum, ELEM_CNT * (ELEM_CNT - 1) / 2);
+  msg ("sum is %d", sum);
+
+  CHECK (uthread_join (tids[0]) == -1, "second join fails");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread-basic) begin
+(uthread-basic) started 4 threads
+(uthread-basic) got 42 through a futex
+(uthread-basic) join giver
+(uthread-basic) joined 4 threads
+(uthread-basic) sum is 8386560
+(uthread-basic) second join fails
+(uthread-basic) end
+uthread-basic: exit(0)
+EOF
+pass;
@@ -0,0 +1,47 @@
+/* A thread blocks reading an empty pipe whose write end stays
+   open while the main thread calls exit().  The process must
+   still exit: the reader gives up its read instead of holding up
+   the main thread, which waits for its other threads before it
+   closes the descriptors. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define STACK_SIZE 4096
+
+static char stack[STACK_SIZE] __attribute__ ((aligned (16)));
+static int fds[2];
+static int started;
+
+static void
+reader (void *aux UNUSED)
+{
+  char c;
+  int n;
+
+  started = 1;
+  futex (&started, FUTEX_WAKE, 1);
+  n = read (fds[0], &c, 1);
+  fail ("read() returned %d", n);
+}
+
+void
+test_main (void) 
+{
+  volatile int i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (uthread_create (reader, NULL, stack + STACK_SIZE) != TID_ERROR,
+         "uthread_create");
+  while (started == 0)
+    futex (&started, FUTEX_WAIT, 0);
+
+  /* Give the reader time to go to sleep in read(). */
+  for (i = 0; i < 1000000; i++)
+    continue;
+
+  msg ("exiting with reader blocked");
+  exit (0);
+}
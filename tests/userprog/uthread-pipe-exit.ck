@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread-pipe-exit) begin
+(uthread-pipe-exit) pipe
+(uthread-pipe-exit) uthread_create
+(uthread-pipe-exit) exiting with reader blocked
+uthread-pipe-exit: exit(0)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Reads the clock and the process id from the vDSO page.  The
+   tick count must advance on its own, and a forked child must
+   see its own pid, which it passes back through a pipe. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int64_t start;
+  pid_t child_pid, pid;
+  int fds[2];
+
+  CHECK (vdso_timer_freq () == 100, "timer frequency is 100 Hz");
+
+  start = vdso_ticks ();
+  while (vdso_ticks () == start)
+    continue;
+  msg ("tick count advanced");
+
+  CHECK (pipe (fds) == 0, "pipe");
+  if ((pid = fork ("child")) == 0)
+    {
+      child_pid = vdso_getpid ();
+      write (fds[1], &child_pid, sizeof child_pid);
+      exit (0);
+    }
+  if (read (fds[0], &child_pid, sizeof child_pid) != sizeof child_pid)
+    fail ("read() from pipe failed");
+  wait (pid);
+  if (child_pid != pid)
+    fail ("child saw pid %d, fork() returned %d", child_pid, pid);
+  if (vdso_getpid () == pid)
+    fail ("parent saw the child's pid");
+  msg ("pids match");
+}
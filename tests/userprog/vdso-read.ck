@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vdso-read) begin
+(vdso-read) timer frequency is 100 Hz
+(vdso-read) tick count advanced
+(vdso-read) pipe
+child: exit(0)
+(vdso-read) pids match
+(vdso-read) end
+vdso-read: exit(0)
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Writes "sample.txt" into a new file with writev() in three
+   pieces, then reads it back with readv(). */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t third = size / 3;
+  struct iovec iov[3];
+  int handle;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = third;
+  iov[1].iov_base = sample + third;
+  iov[1].iov_len = third;
+  iov[2].iov_base = sample + 2 * third;
+  iov[2].iov_len = size - 2 * third;
+  if (writev (handle, iov, 3) != (int) size)
+    fail ("writev() did not write %zu bytes", size);
+
+  seek (handle, 0);
+  iov[0].iov_base = buf;
+  iov[1].iov_base = buf + third;
+  iov[2].iov_base = buf + 2 * third;
+  if (readv (handle, iov, 3) != (int) size)
+    fail ("readv() did not read %zu bytes", size);
+  compare_bytes (buf, sample, size, 0, "test.txt");
+  msg ("close \"test.txt\"");
+  close (handle);
+}
@@ -21,6 +21,7 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -95,6 +96,7 @@ main (void) {
 	/* Initialize interrupt handlers. */
 	intr_init ();
 	timer_init ();
+	work_pool_init ();
 	kbd_init ();
 	input_init ();
 #ifdef USERPROG
@@ -103,6 +105,8 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	palloc_start_zeroing ();
+	work_pool_start ();
 	serial_init_queue ();
 	timer_calibrate ();
 
@@ -221,6 +225,10 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -230,10 +238,18 @@ parse_options (char **argv) {
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
+	if (thread_mlfqs && thread_cfs)
+		PANIC ("options -mlfqs and -cfs are mutually exclusive");
 
 	return argv;
 }
 
+/* Prints page allocator statistics. */
+static void
+print_palloc_stats (char **argv UNUSED) {
+	palloc_print_stats ();
+}
+
 /* Runs the task specified in ARGV[1]. */
 static void
 run_task (char **argv) {
@@ -266,6 +282,7 @@ run_actions (char **argv) {
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		{"run", 2, run_task},
+		{"palloc-stats", 1, print_palloc_stats},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
 		{"cat", 2, fsutil_cat},
@@ -312,6 +329,7 @@ usage (void) {
 #else
 			"  run TEST           Run TEST.\n"
 #endif
+			"  palloc-stats       Print page allocator fragmentation and latency.\n"
 #ifdef FILESYS
 			"  ls                 List files in the root directory.\n"
 			"  cat FILE           Print FILE to the console.\n"
@@ -326,6 +344,8 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair (vruntime) scheduler.\n"
+			"  -tickless          Stop the timer tick while idle.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -362,4 +382,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -7,6 +7,7 @@
 #include <string.h>
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -28,6 +29,16 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   Each thread also keeps a small "magazine" of free blocks per
+   descriptor, chained through the blocks themselves.  malloc()
+   and free() use only the running thread's magazine when they
+   can, which needs no lock since no other thread touches it.
+   An empty magazine is refilled, and a full one half drained,
+   with MAG_BATCH blocks under a single acquisition of the
+   descriptor's lock.  Blocks in a magazine still count as in
+   use in their arena, so malloc_drain() must return them when
+   the thread exits.
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
@@ -54,15 +65,28 @@ struct arena {
 
 /* Free block. */
 struct block {
-	struct list_elem free_elem; /* Free list element. */
+	union {
+		struct list_elem free_elem; /* Free list element. */
+		struct block *mag_next;     /* Next block in a magazine. */
+	};
 };
 
+/* Magazine capacity, per descriptor, and the number of blocks
+   moved at once between a magazine and its descriptor. */
+#define MAG_SIZE 16
+#define MAG_BATCH (MAG_SIZE / 2)
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_CLASS_CNT];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* If false, malloc() and free() bypass the magazines. */
+bool malloc_use_magazines = true;
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_get_block (struct desc *);
+static void desc_put_block (struct desc *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -77,6 +101,30 @@ malloc_init (void) {
 		list_init (&d->free_list);
 		lock_init (&d->lock);
 	}
+	ASSERT (desc_cnt == MALLOC_CLASS_CNT);
+}
+
+/* Returns every block in the running thread's magazines to its
+   descriptor.  Called when the thread exits. */
+void
+malloc_drain (void) {
+	struct malloc_magazine *mag = &thread_current ()->magazine;
+	size_t i;
+
+	for (i = 0; i < desc_cnt; i++) {
+		struct desc *d = &descs[i];
+
+		if (mag->cnt[i] == 0)
+			continue;
+		lock_acquire (&d->lock);
+		while (mag->head[i] != NULL) {
+			struct block *b = mag->head[i];
+			mag->head[i] = b->mag_next;
+			desc_put_block (d, b);
+		}
+		mag->cnt[i] = 0;
+		lock_release (&d->lock);
+	}
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -112,7 +160,47 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
+	if (malloc_use_magazines) {
+		struct malloc_magazine *mag = &thread_current ()->magazine;
+		size_t i = d - descs;
+
+		/* Refill an empty magazine with a batch of blocks. */
+		if (mag->cnt[i] == 0) {
+			lock_acquire (&d->lock);
+			while (mag->cnt[i] < MAG_BATCH) {
+				b = desc_get_block (d);
+				if (b == NULL)
+					break;
+				b->mag_next = mag->head[i];
+				mag->head[i] = b;
+				mag->cnt[i]++;
+			}
+			lock_release (&d->lock);
+			if (mag->cnt[i] == 0)
+				return NULL;
+		}
+
+		b = mag->head[i];
+		mag->head[i] = b->mag_next;
+		mag->cnt[i]--;
+		return b;
+	}
+
 	lock_acquire (&d->lock);
+	b = desc_get_block (d);
+	lock_release (&d->lock);
+	return b;
+}
+
+/* Takes a block from descriptor D, which must be locked, adding
+   a new arena if D has no free blocks.  Returns a null pointer
+   if memory is not available. */
+static struct block *
+desc_get_block (struct desc *d) {
+	struct block *b;
+	struct arena *a;
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
 
 	/* If the free list is empty, create a new arena. */
 	if (list_empty (&d->free_list)) {
@@ -120,10 +208,8 @@ malloc (size_t size) {
 
 		/* Allocate a page. */
 		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
+		if (a == NULL)
 			return NULL;
-		}
 
 		/* Initialize arena and add its blocks to the free list. */
 		a->magic = ARENA_MAGIC;
@@ -139,10 +225,33 @@ malloc (size_t size) {
 	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
 	a = block_to_arena (b);
 	a->free_cnt--;
-	lock_release (&d->lock);
 	return b;
 }
 
+/* Returns block B to descriptor D, which must be locked,
+   freeing B's arena if none of its blocks is in use any more. */
+static void
+desc_put_block (struct desc *d, struct block *b) {
+	struct arena *a = block_to_arena (b);
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
+
+	/* Add block to free list. */
+	list_push_front (&d->free_list, &b->free_elem);
+
+	/* If the arena is now entirely unused, free it. */
+	if (++a->free_cnt >= d->blocks_per_arena) {
+		size_t i;
+
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_remove (&b->free_elem);
+		}
+		palloc_free_page (a);
+	}
+}
+
 /* Allocates and return A times B bytes initialized to zeroes.
    Returns a null pointer if memory is not available. */
 void *
@@ -173,17 +282,44 @@ block_size (void *block) {
 	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
+/* Tries to resize OLD_BLOCK to NEW_SIZE bytes without moving it.
+   A normal block can hold anything up to its descriptor's block
+   size.  A big block gives back pages it no longer needs, or
+   claims the free pages right after it.  Returns true if
+   successful. */
+static bool
+resize_in_place (void *old_block, size_t new_size) {
+	struct arena *a = block_to_arena (old_block);
+	size_t page_cnt;
+
+	if (a->desc != NULL)
+		return new_size <= a->desc->block_size;
+
+	page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+	if (page_cnt < a->free_cnt)
+		palloc_free_multiple ((uint8_t *) a + page_cnt * PGSIZE,
+				a->free_cnt - page_cnt);
+	else if (page_cnt > a->free_cnt
+			&& !palloc_extend (a, a->free_cnt, page_cnt))
+		return false;
+	a->free_cnt = page_cnt;
+	return true;
+}
+
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
    moving it in the process.
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   The block stays where it is whenever possible. */
 void *
 realloc (void *old_block, size_t new_size) {
 	if (new_size == 0) {
 		free (old_block);
 		return NULL;
+	} else if (old_block != NULL && resize_in_place (old_block, new_size)) {
+		return old_block;
 	} else {
 		void *new_block = malloc (new_size);
 		if (old_block != NULL && new_block != NULL) {
@@ -213,23 +349,30 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
+			if (malloc_use_magazines) {
+				struct malloc_magazine *mag = &thread_current ()->magazine;
+				size_t i = d - descs;
+
+				/* Drain half of a full magazine in one batch. */
+				if (mag->cnt[i] >= MAG_SIZE) {
+					lock_acquire (&d->lock);
+					while (mag->cnt[i] > MAG_SIZE - MAG_BATCH) {
+						struct block *old = mag->head[i];
+						mag->head[i] = old->mag_next;
+						mag->cnt[i]--;
+						desc_put_block (d, old);
+					}
+					lock_release (&d->lock);
 				}
-				palloc_free_page (a);
+
+				b->mag_next = mag->head[i];
+				mag->head[i] = b;
+				mag->cnt[i]++;
+				return;
 			}
 
+			lock_acquire (&d->lock);
+			desc_put_block (d, b);
 			lock_release (&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
@@ -2,15 +2,19 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "intrinsic.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -24,24 +28,88 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept
+   as blocks of 2**K pages, aligned to 2**K pages within the
+   pool, on one free list per order K.  A request for N pages
+   takes the smallest block of at least N pages, splitting
+   larger blocks in half as needed, and gives any pages past N
+   back.  Freeing a block merges it with its buddy, the other
+   half of the block it was split from, for as long as the buddy
+   is free too.  Both take time logarithmic in the pool size.
+
+   A free block's list element lives in its first page, and the
+   pool's order map records, for the first page of each free
+   block, the block's order plus 1, and 0 for every other page.
+   The used map is kept only to catch double frees.
+
+   A pool's free lists are updated with interrupts disabled,
+   rather than under a lock, because the scheduler frees the
+   pages of dying threads with interrupts already off.
+
+   So that PAL_ZERO requests need not clear pages on the spot, a
+   low-priority kernel thread keeps a reservoir of up to
+   ZERO_TARGET zeroed pages in each pool, topping it up whenever
+   it falls below half.  Single-page PAL_ZERO requests are
+   served from the reservoir when it has a page.  When the pool
+   is otherwise exhausted, a single-page request takes a page
+   from the reservoir, and a larger one returns the whole
+   reservoir to the free lists and tries again. */
+
+/* Number of block orders.  The largest block is
+   2**(MAX_ORDER - 1) pages. */
+#define MAX_ORDER 20
+
+/* Size of each pool's zeroed page reservoir. */
+#define ZERO_TARGET 32
+
+/* Allocator statistics for a pool. */
+struct pool_stats {
+	uint64_t alloc_cnt;             /* Successful allocations. */
+	uint64_t fail_cnt;              /* Failed allocations. */
+	uint64_t split_cnt;             /* Blocks split in two. */
+	uint64_t merge_cnt;             /* Buddies merged. */
+	uint64_t alloc_cycles;          /* Cycles spent allocating. */
+	uint64_t max_alloc_cycles;      /* Longest allocation. */
+	uint64_t zero_hits;             /* PAL_ZERO pages from reservoir. */
+	uint64_t zero_misses;           /* PAL_ZERO pages zeroed inline. */
+	uint64_t zero_filled;           /* Pages zeroed in background. */
+};
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *order_map;             /* Order + 1 of free block heads. */
+	struct list free[MAX_ORDER];    /* Free blocks, by order. */
+	size_t free_cnt;                /* Number of free pages. */
+	struct list zeroed;             /* Reservoir of zeroed pages. */
+	size_t zeroed_cnt;              /* Number of pages in reservoir. */
+	struct pool_stats stats;        /* Statistics. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Background zeroing thread, and how to wake it. */
+static bool zero_thread_started;
+static struct semaphore zero_sema;
+static thread_func zero_thread;
+
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void seed_pool (struct pool *);
+static void *alloc_pages (struct pool *, size_t page_cnt);
+static void free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void claim_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void print_pool_stats (const char *name, struct pool *);
+static void *take_zeroed (struct pool *);
+static void drain_zeroed (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -250,6 +318,8 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	seed_pool (&kernel_pool);
+	seed_pool (&user_pool);
 	return ext_mem.end;
 }
 
@@ -262,19 +332,41 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	enum intr_level old_level;
 	void *pages;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	bool zeroed = false;
+
+	old_level = intr_disable ();
+	if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed_cnt > 0) {
+		pages = take_zeroed (pool);
+		zeroed = true;
+	} else {
+		pages = alloc_pages (pool, page_cnt);
+		if (pages == NULL && pool->zeroed_cnt > 0) {
+			if (page_cnt == 1) {
+				pages = take_zeroed (pool);
+				zeroed = true;
+			} else {
+				/* The reservoir's pages may be what keeps the
+				   free blocks from being big enough. */
+				drain_zeroed (pool);
+				pages = alloc_pages (pool, page_cnt);
+			}
+		}
+	}
+	if (pages == NULL)
+		pool->stats.fail_cnt++;
+	if (flags & PAL_ZERO) {
+		if (zeroed)
+			pool->stats.zero_hits++;
+		else if (pages != NULL)
+			pool->stats.zero_misses++;
+	}
+	intr_set_level (old_level);
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -301,6 +393,7 @@ void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -318,8 +411,47 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	free_range (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
+}
+
+/* Tries to grow the run of OLD_CNT pages starting at PAGES, which
+   came from palloc_get_multiple(), to NEW_CNT pages by claiming
+   the pages that follow it.  Returns true if successful, false
+   if any of those pages is not free, in which case nothing
+   changes. */
+bool
+palloc_extend (void *pages, size_t old_cnt, size_t new_cnt) {
+	struct pool *pool;
+	size_t page_idx, end;
+	enum intr_level old_level;
+	bool success = false;
+
+	ASSERT (pg_ofs (pages) == 0);
+	ASSERT (old_cnt > 0 && new_cnt >= old_cnt);
+
+	if (page_from_pool (&kernel_pool, pages))
+		pool = &kernel_pool;
+	else if (page_from_pool (&user_pool, pages))
+		pool = &user_pool;
+	else
+		NOT_REACHED ();
+
+	page_idx = pg_no (pages) - pg_no (pool->base) + old_cnt;
+	end = page_idx + (new_cnt - old_cnt);
+
+	old_level = intr_disable ();
+	if (end <= bitmap_size (pool->used_map)
+			&& !bitmap_contains (pool->used_map, page_idx, end - page_idx, true)) {
+		claim_range (pool, page_idx, end - page_idx);
+		bitmap_set_multiple (pool->used_map, page_idx, end - page_idx, true);
+		success = true;
+	}
+	intr_set_level (old_level);
+	return success;
 }
 
 /* Frees the page at PAGE. */
@@ -336,8 +468,9 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t om_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
 
@@ -345,6 +478,324 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	bitmap_set_all(p->used_map, true);
 
 	*bm_base += bm_pages;
+
+	// The order map follows the used map.  No block is free yet.
+	p->order_map = *bm_base;
+	memset (p->order_map, 0, pgcnt);
+	*bm_base += om_pages;
+
+	for (order = 0; order < MAX_ORDER; order++)
+		list_init (&p->free[order]);
+	p->free_cnt = 0;
+	list_init (&p->zeroed);
+	p->zeroed_cnt = 0;
+	memset (&p->stats, 0, sizeof p->stats);
+}
+
+/* Puts every page that populate_pools() marked usable in POOL
+   on its free lists. */
+static void
+seed_pool (struct pool *pool) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+	size_t start = 0;
+
+	while (start < page_cnt) {
+		size_t end;
+
+		start = bitmap_scan (pool->used_map, start, 1, false);
+		if (start == BITMAP_ERROR)
+			break;
+		end = bitmap_scan (pool->used_map, start, 1, true);
+		if (end == BITMAP_ERROR)
+			end = page_cnt;
+		free_range (pool, start, end - start);
+		start = end;
+	}
+	pool->stats.merge_cnt = 0;
+}
+
+/* Returns the smallest order whose blocks hold PAGE_CNT pages. */
+static int
+order_for (size_t page_cnt) {
+	int order = 0;
+
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Returns the address of page PAGE_IDX in POOL. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx) {
+	return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the index in POOL of the block whose list element is
+   E. */
+static size_t
+elem_block (struct pool *pool, struct list_elem *e) {
+	return ((uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Puts the free block of 2**ORDER pages at PAGE_IDX in POOL on
+   its free list, first merging it with its buddy as long as the
+   buddy is free. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+
+	pool->free_cnt += (size_t) 1 << order;
+	while (order < MAX_ORDER - 1) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > page_cnt
+				|| pool->order_map[buddy] != order + 1)
+			break;
+		list_remove (block_elem (pool, buddy));
+		pool->order_map[buddy] = 0;
+		pool->stats.merge_cnt++;
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+	pool->order_map[page_idx] = order + 1;
+	list_push_front (&pool->free[order], block_elem (pool, page_idx));
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in POOL, as the
+   largest aligned blocks that fit. */
+static void
+free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < MAX_ORDER - 1
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		free_block (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Takes the PAGE_CNT pages starting at PAGE_IDX, all of which
+   must be free, off POOL's free lists.  Each free block that
+   overlaps the range is removed, and its pages outside the range
+   are freed again. */
+static void
+claim_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	size_t end = page_idx + page_cnt;
+
+	while (page_idx < end) {
+		size_t head = page_idx, block_cnt;
+		int order;
+
+		/* Find the free block that contains PAGE_IDX. */
+		for (order = 0; order < MAX_ORDER; order++) {
+			head = page_idx & ~(((size_t) 1 << order) - 1);
+			if (pool->order_map[head] == order + 1)
+				break;
+		}
+		ASSERT (order < MAX_ORDER);
+		block_cnt = (size_t) 1 << order;
+
+		list_remove (block_elem (pool, head));
+		pool->order_map[head] = 0;
+		pool->free_cnt -= block_cnt;
+
+		/* Put back the parts of the block outside the range. */
+		free_range (pool, head, page_idx - head);
+		if (head + block_cnt > end) {
+			free_range (pool, end, head + block_cnt - end);
+			page_idx = end;
+		} else
+			page_idx = head + block_cnt;
+	}
+}
+
+/* Takes PAGE_CNT contiguous pages from POOL and returns the first, or a null pointer if no free
+   block is big enough. */
+static void *
+alloc_pages (struct pool *pool, size_t page_cnt) {
+	uint64_t start = rdtsc ();
+	int order = order_for (page_cnt);
+	size_t page_idx;
+	uint64_t cycles;
+	int k;
+
+	/* Find the smallest free block that is big enough. */
+	for (k = order; k < MAX_ORDER; k++)
+		if (!list_empty (&pool->free[k]))
+			break;
+	if (k >= MAX_ORDER)
+		return NULL;
+	page_idx = elem_block (pool, list_pop_front (&pool->free[k]));
+	pool->order_map[page_idx] = 0;
+	pool->free_cnt -= (size_t) 1 << k;
+
+	/* Split it down to size, keeping the lower half. */
+	while (k > order) {
+		k--;
+		pool->order_map[page_idx + ((size_t) 1 << k)] = k + 1;
+		list_push_front (&pool->free[k],
+				block_elem (pool, page_idx + ((size_t) 1 << k)));
+		pool->free_cnt += (size_t) 1 << k;
+		pool->stats.split_cnt++;
+	}
+
+	/* Give back the pages past PAGE_CNT. */
+	free_range (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+	ASSERT (!bitmap_contains (pool->used_map, page_idx, page_cnt, true));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+
+	cycles = rdtsc () - start;
+	pool->stats.alloc_cnt++;
+	pool->stats.alloc_cycles += cycles;
+	if (cycles > pool->stats.max_alloc_cycles)
+		pool->stats.max_alloc_cycles = cycles;
+	return pool->base + PGSIZE * page_idx;
+}
+
+/* Takes a page from POOL's zeroed reservoir, which must not be
+   empty, and wakes the zeroing thread if the reservoir is
+   running low.  Interrupts must be off. */
+static void *
+take_zeroed (struct pool *pool) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (pool->zeroed_cnt > 0);
+
+	e = list_pop_front (&pool->zeroed);
+	pool->zeroed_cnt--;
+	if (pool->zeroed_cnt == ZERO_TARGET / 2 && zero_thread_started)
+		sema_up (&zero_sema);
+
+	/* The list element was the only nonzero part of the page. */
+	memset (e, 0, sizeof *e);
+	return e;
+}
+
+/* Returns every page in POOL's zeroed reservoir to its free
+   lists.  Interrupts must be off. */
+static void
+drain_zeroed (struct pool *pool) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&pool->zeroed)) {
+		size_t page_idx = elem_block (pool, list_pop_front (&pool->zeroed));
+
+		bitmap_set_multiple (pool->used_map, page_idx, 1, false);
+		free_block (pool, page_idx, 0);
+	}
+	pool->zeroed_cnt = 0;
+	if (zero_thread_started)
+		sema_up (&zero_sema);
+}
+
+/* Zeroes one more page for POOL's reservoir, if it is below
+   target and the pool has a free page.  Returns true if it
+   added a page. */
+static bool
+refill_zeroed (struct pool *pool) {
+	enum intr_level old_level;
+	void *page;
+
+	old_level = intr_disable ();
+	page = pool->zeroed_cnt < ZERO_TARGET ? alloc_pages (pool, 1) : NULL;
+	intr_set_level (old_level);
+	if (page == NULL)
+		return false;
+
+	memset (page, 0, PGSIZE);
+
+	old_level = intr_disable ();
+	list_push_back (&pool->zeroed, page);
+	pool->zeroed_cnt++;
+	pool->stats.zero_filled++;
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Keeps both pools' reservoirs full, sleeping whenever there is
+   nothing to do.  Runs at the lowest priority, so it only gets
+   the CPU when nothing else wants it. */
+static void
+zero_thread (void *aux UNUSED) {
+	/* The MLFQ and fair schedulers ignore the priority we were
+	   created with. */
+	if (thread_mlfqs || thread_cfs)
+		thread_set_nice (NICE_MAX);
+
+	for (;;) {
+		bool kernel = refill_zeroed (&kernel_pool);
+		bool user = refill_zeroed (&user_pool);
+
+		if (!kernel && !user)
+			sema_down (&zero_sema);
+	}
+}
+
+/* Starts the background zeroing thread.  Must be called after
+   thread_start(). */
+void
+palloc_start_zeroing (void) {
+	sema_init (&zero_sema, 0);
+	zero_thread_started = true;
+	thread_create ("zeroer", PRI_MIN, zero_thread, NULL);
+}
+
+/* Prints fragmentation and latency statistics for POOL. */
+static void
+print_pool_stats (const char *name, struct pool *pool) {
+	struct pool_stats stats;
+	size_t blocks[MAX_ORDER];
+	size_t free_cnt;
+	int largest = -1;
+	int order;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	stats = pool->stats;
+	free_cnt = pool->free_cnt;
+	for (order = 0; order < MAX_ORDER; order++) {
+		blocks[order] = list_size (&pool->free[order]);
+		if (blocks[order] > 0)
+			largest = order;
+	}
+	intr_set_level (old_level);
+
+	printf ("%s pool: %zu of %zu pages free",
+			name, free_cnt, bitmap_size (pool->used_map));
+	if (largest >= 0)
+		printf (", largest free block %zu pages, fragmentation %zu%%",
+				(size_t) 1 << largest,
+				100 - ((size_t) 100 << largest) / free_cnt);
+	printf ("\n  free blocks by order:");
+	for (order = 0; order <= largest; order++)
+		printf (" %zu", blocks[order]);
+	printf ("\n  %"PRIu64" allocations, %"PRIu64" failed, "
+			"%"PRIu64" splits, %"PRIu64" merges\n",
+			stats.alloc_cnt, stats.fail_cnt, stats.split_cnt, stats.merge_cnt);
+	if (stats.alloc_cnt > 0)
+		printf ("  allocation latency: %"PRIu64" cycles average, "
+				"%"PRIu64" max\n",
+				stats.alloc_cycles / stats.alloc_cnt, stats.max_alloc_cycles);
+	if (stats.zero_hits + stats.zero_misses > 0)
+		printf ("  zeroed pages: %"PRIu64" from reservoir, %"PRIu64" inline "
+				"(%"PRIu64"%% hit rate), %"PRIu64" zeroed in background\n",
+				stats.zero_hits, stats.zero_misses,
+				stats.zero_hits * 100 / (stats.zero_hits + stats.zero_misses),
+				stats.zero_filled);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	print_pool_stats ("Kernel", &kernel_pool);
+	print_pool_stats ("User", &user_pool);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -0,0 +1,219 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator, after Bonwick's.
+
+   Each cache hands out objects of one exact size, rounded up
+   only to pointer alignment, instead of malloc()'s next power of
+   2.  A cache carves whole pages, called "slabs", into objects.
+   The slab header sits at the start of the page, so an object's
+   slab is found with pg_round_down(), and is followed by a stack
+   holding the indexes of the slab's free objects.
+
+   Free objects are tracked outside the objects themselves, so
+   an object keeps whatever state it had when it was freed.  A
+   cache's constructor runs once per object, when a new slab is
+   carved; an object that is freed must be returned in its
+   constructed state, and is handed out again as-is.
+
+   Slabs with free objects sit on the cache's partial list;
+   full slabs are on no list.  When a slab becomes entirely
+   free it goes back to the page allocator, except that one
+   empty slab is kept to avoid thrashing at the boundary. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* An object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Object size, rounded up. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	size_t obj_ofs;             /* Offset of the first object. */
+	kmem_ctor *ctor;            /* Constructor, or null. */
+	struct lock lock;           /* Protects the members below. */
+	struct list partial;        /* Slabs with free objects. */
+	struct slab *empty;         /* One wholly free slab, or null. */
+	size_t slab_cnt;            /* Number of slabs, including empty. */
+	size_t alloc_cnt;           /* Number of objects allocated. */
+};
+
+/* Header of a slab. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in cache's partial list. */
+	size_t free_cnt;            /* Number of free objects. */
+	uint16_t free[];            /* Indexes of free objects. */
+};
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Creates and returns a cache of SIZE-byte objects, named NAME.
+   If CTOR is nonnull, it is called on each object when the
+   object is first carved out of a page.  Returns a null pointer
+   if memory is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor) {
+	struct kmem_cache *c;
+	size_t n;
+
+	ASSERT (size > 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		return NULL;
+
+	c->name = name;
+	c->obj_size = ROUND_UP (size, sizeof (void *));
+	c->ctor = ctor;
+	lock_init (&c->lock);
+	list_init (&c->partial);
+	c->empty = NULL;
+	c->slab_cnt = 0;
+	c->alloc_cnt = 0;
+
+	/* Find how many objects fit in a page beside the header and
+	   its free index stack. */
+	for (n = PGSIZE / c->obj_size; n > 0; n--) {
+		size_t ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+				sizeof (void *));
+		if (ofs + n * c->obj_size <= PGSIZE) {
+			c->obj_ofs = ofs;
+			break;
+		}
+	}
+	ASSERT (n > 0);
+	c->objs_per_slab = n;
+	return c;
+}
+
+/* Obtains and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	size_t idx;
+
+	lock_acquire (&c->lock);
+
+	/* Find a slab with a free object, reusing the empty slab or
+	   making a new one if there is none. */
+	if (list_empty (&c->partial)) {
+		if (c->empty != NULL) {
+			s = c->empty;
+			c->empty = NULL;
+		} else {
+			s = slab_create (c);
+			if (s == NULL) {
+				lock_release (&c->lock);
+				return NULL;
+			}
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+	s = list_entry (list_front (&c->partial), struct slab, elem);
+
+	/* Take an object; a slab that fills up leaves the list. */
+	idx = s->free[--s->free_cnt];
+	if (s->free_cnt == 0)
+		list_remove (&s->elem);
+	c->alloc_cnt++;
+
+	lock_release (&c->lock);
+	return (uint8_t *) s + c->obj_ofs + idx * c->obj_size;
+}
+
+/* Returns OBJ, which must have come from cache C, to C. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+	idx = ((uint8_t *) obj - ((uint8_t *) s + c->obj_ofs)) / c->obj_size;
+
+	lock_acquire (&c->lock);
+
+	ASSERT (s->free_cnt < c->objs_per_slab);
+	s->free[s->free_cnt++] = idx;
+	c->alloc_cnt--;
+
+	if (s->free_cnt == 1)
+		list_push_front (&c->partial, &s->elem);
+	if (s->free_cnt == c->objs_per_slab) {
+		/* Keep one empty slab; give back any more. */
+		list_remove (&s->elem);
+		if (c->empty == NULL)
+			c->empty = s;
+		else {
+			c->slab_cnt--;
+			palloc_free_page (s);
+		}
+	}
+
+	lock_release (&c->lock);
+}
+
+/* Prints statistics for cache C. */
+void
+kmem_cache_print_stats (struct kmem_cache *c) {
+	lock_acquire (&c->lock);
+	printf ("Cache %s: %zu-byte objects, %zu in use, %zu slabs of %zu\n",
+			c->name, c->obj_size, c->alloc_cnt, c->slab_cnt,
+			c->objs_per_slab);
+	lock_release (&c->lock);
+}
+
+/* Allocates a new slab for cache C, which must be locked, and
+   constructs all of its objects.  Returns a null pointer if
+   memory is not available. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free_cnt = c->objs_per_slab;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		/* Hand out low addresses first. */
+		s->free[i] = c->objs_per_slab - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor ((uint8_t *) s + c->obj_ofs + i * c->obj_size);
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is inside. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid. */
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+	/* Check that the object is properly aligned for the slab. */
+	ASSERT (pg_ofs (obj) >= c->obj_ofs);
+	ASSERT ((pg_ofs (obj) - c->obj_ofs) % c->obj_size == 0);
+
+	return s;
+}
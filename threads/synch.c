@@ -32,6 +32,11 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+static bool waiter_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static bool cond_waiter_less (const struct heap_elem *,
+		const struct heap_elem *, void *aux);
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -46,7 +51,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,7 +71,13 @@ sema_down (struct semaphore *sema) {
 
 	old_level = intr_disable ();
 	while (sema->value == 0) {
-      list_insert_ordered(&sema->waiters, &thread_current()->elem, priority_more, NULL);
+		struct thread *cur = thread_current ();
+
+		heap_push (&sema->waiters, &cur->sema_elem);
+		if (cur->wait_heap == NULL) {
+			cur->wait_heap = &sema->waiters;
+			cur->wait_heap_elem = &cur->sema_elem;
+		}
 		thread_block ();
 	}
 	sema->value--;
@@ -109,9 +120,13 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters)) {
-		list_sort(&sema->waiters, priority_more, NULL);
-		thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
+	if (!heap_empty (&sema->waiters)) {
+		struct thread *t = heap_entry (heap_pop (&sema->waiters),
+				struct thread, sema_elem);
+
+		if (t->wait_heap == &sema->waiters)
+			t->wait_heap = NULL;
+		thread_unblock (t);
 	}
 	sema->value++;
  
@@ -120,6 +135,27 @@ sema_up (struct semaphore *sema) {
 	intr_set_level (old_level);
 }
 
+/* Keeps the waiter heap that T is blocked in, if any, in
+   priority order after T's priority changes.  Must be called
+   with interrupts off. */
+void
+synch_priority_changed (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->wait_heap != NULL)
+		heap_update (t->wait_heap, t->wait_heap_elem);
+}
+
+/* Orders threads in a semaphore's waiters by priority. */
+static bool
+waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, sema_elem);
+	const struct thread *b = heap_entry (b_, struct thread, sema_elem);
+
+	return a->priority < b->priority;
+}
+
 static void sema_test_helper (void *sema_);
 
 /* Self-test for semaphores that makes control "ping-pong"
@@ -175,23 +211,31 @@ lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
+	lock->max_priority = PRI_MIN - 1;
 	sema_init (&lock->semaphore, 1);
 }
 
 
-/* inversion */
-bool
-donations_priority_more (const struct list_elem *a_, const struct list_elem *b_,
-            void *aux UNUSED) { 
-	struct thread *a = list_entry (a_, struct thread, donations_elem);
-	struct thread *b = list_entry (b_, struct thread, donations_elem);
-
-	return a->priority > b->priority;
+/* Makes the current thread the holder of LOCK, which it has just
+   downed.  Any threads still waiting keep donating to it, so
+   LOCK goes into the current thread's held locks keyed by the
+   highest remaining waiter priority.  Must be called with
+   interrupts off. */
+static void
+lock_take (struct lock *lock) {
+	struct thread *cur = thread_current ();
+	struct heap_elem *top = heap_top (&lock->semaphore.waiters);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lock->holder = cur;
+	lock->max_priority = top != NULL
+		? heap_entry (top, struct thread, sema_elem)->priority : PRI_MIN - 1;
+	heap_push (&cur->held_locks, &lock->held_elem);
+	if (!thread_mlfqs && !thread_cfs)
+		refresh_priority ();
 }
 
-
-
-
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -206,28 +250,23 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-   struct thread *cur = thread_current();
-
-   if (lock->holder != NULL) {
-      // put signal that this thread is waiting for the lock
-      cur->waiting_lock = lock;
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
 
-      /* project 2 required(?)*/
-      // list_insert_ordered(&lock->holder->donations, &cur->donations_elem, donations_priority_more, NULL);
-      /* project 3 VM 
-      should be edited for page-merge-stk/mm, in this code*/
-      list_push_back(&lock->holder->donations, &cur->donations_elem);
-      
-      // nested donation of priority
-      if (!thread_mlfqs) {
-         donate_priority();
-      }
-   }
+	old_level = intr_disable ();
+	if (lock->holder != NULL) {
+		// put signal that this thread is waiting for the lock
+		cur->waiting_lock = lock;
 
-   sema_down (&lock->semaphore);
-   cur->waiting_lock = NULL;
+		// nested donation of priority
+		if (!thread_mlfqs && !thread_cfs)
+			donate_priority ();
+	}
 
-   lock->holder = thread_current();
+	sema_down (&lock->semaphore);
+	cur->waiting_lock = NULL;
+	lock_take (lock);
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -238,14 +277,17 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
 	success = sema_try_down (&lock->semaphore);
 	if (success)
-		lock->holder = thread_current ();
+		lock_take (lock);
+	intr_set_level (old_level);
 	return success;
 }
 
@@ -257,16 +299,20 @@ lock_try_acquire (struct lock *lock) {
    handler. */
 void
 lock_release (struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
-   
-   if (!thread_mlfqs) {
-      remove_with_lock(lock);
-      refresh_priority();
-   }
 
-   lock->holder = NULL;
-   sema_up (&lock->semaphore);
+	/* The donations that came through LOCK go with it. */
+	old_level = intr_disable ();
+	heap_remove (&thread_current ()->held_locks, &lock->held_elem);
+	lock->holder = NULL;
+	if (!thread_mlfqs && !thread_cfs)
+		refresh_priority ();
+	intr_set_level (old_level);
+
+	sema_up (&lock->semaphore);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -279,10 +325,158 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* Initializes RWLOCK.  A reader-writer lock can be held either
+   by any number of readers at once or by a single writer.
+
+   Writers are preferred: once a writer starts waiting, readers
+   that arrive after it wait too, so a steady stream of readers
+   cannot starve it.  This falls out of building the lock around
+   an ordinary lock that a writer holds for the whole of its
+   write, including while it waits for the readers already inside
+   to leave.  Readers take that lock only for the moment it takes
+   to enter, so they queue behind any writer, and since waiting
+   for a lock donates priority to its holder, every thread that
+   waits on the lock lends its priority to the writer.  Readers
+   inside the lock get no donations.
+
+   Like locks, reader-writer locks are not recursive. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	rw->readers = 0;
+	rw->draining = false;
+	sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it or
+   waits for it if necessary.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	/* With no writer around, skip the lock. */
+	old_level = intr_disable ();
+	if (rw->lock.holder == NULL && heap_empty (&rw->lock.semaphore.waiters)) {
+		rw->readers++;
+		intr_set_level (old_level);
+		return;
+	}
+	intr_set_level (old_level);
+
+	lock_acquire (&rw->lock);
+	old_level = intr_disable ();
+	rw->readers++;
+	intr_set_level (old_level);
+	lock_release (&rw->lock);
+}
+
+/* Tries to acquire RW for reading and returns true if
+   successful or false if a writer holds it or waits for it.
+
+   This function will not sleep, so it may be called within an
+   interrupt handler. */
+bool
+rwlock_try_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	success = rw->lock.holder == NULL
+		&& heap_empty (&rw->lock.semaphore.waiters);
+	if (success)
+		rw->readers++;
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0 && rw->draining) {
+		rw->draining = false;
+		sema_up (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until the writer and any
+   readers inside leave if necessary.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->lock);
+	old_level = intr_disable ();
+	if (rw->readers > 0) {
+		rw->draining = true;
+		sema_down (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Tries to acquire RW for writing and returns true if successful
+   or false if it is held at all.
+
+   This function will not sleep, so it may be called within an
+   interrupt handler. */
+bool
+rwlock_try_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	success = rw->readers == 0 && lock_try_acquire (&rw->lock);
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (rw->readers == 0);
+
+	lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise.  Which threads hold it for reading is not tracked. */
+bool
+rwlock_held_for_write (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->lock);
+}
+
+/* One semaphore in a condition variable's waiters. */
 struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
+	struct heap_elem elem;              /* Heap element. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* Thread waiting on it. */
 };
 
 /* Initializes condition variable COND.  A condition variable
@@ -292,18 +486,18 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
-bool
-sema_priority_more (const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) { 
-	const struct semaphore_elem *a = list_entry (a_, struct semaphore_elem, elem);
-	const struct semaphore_elem *b = list_entry (b_, struct semaphore_elem, elem);
-
-	const struct list *waiter_a = &(a->semaphore.waiters);
-	const struct list *waiter_b = &(b->semaphore.waiters);
+/* Orders a condition variable's waiters by the priority of the
+   thread waiting on each. */
+static bool
+cond_waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct semaphore_elem *a = heap_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = heap_entry (b_, struct semaphore_elem, elem);
 
-	return priority_more(list_begin(waiter_a), list_begin(waiter_b), NULL);
+	return a->thread->priority < b->thread->priority;
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -329,6 +523,7 @@ sema_priority_more (const struct list_elem *a_, const struct list_elem *b_, void
 void
 cond_wait (struct condition *cond, struct lock *lock) {
 	struct semaphore_elem waiter;
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
@@ -336,7 +531,16 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);
-   list_insert_ordered(&cond->waiters, &waiter.elem, sema_priority_more, NULL);
+	waiter.thread = thread_current ();
+
+	/* Until signaled, it is COND's heap, not that of the private
+	   semaphore, that depends on our priority. */
+	old_level = intr_disable ();
+	heap_push (&cond->waiters, &waiter.elem);
+	waiter.thread->wait_heap = &cond->waiters;
+	waiter.thread->wait_heap_elem = &waiter.elem;
+	intr_set_level (old_level);
+
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
 	lock_acquire (lock);
@@ -356,10 +560,20 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)) {
-		list_sort(&cond->waiters, sema_priority_more, NULL);
-		sema_up (&list_entry (list_pop_front (&cond->waiters), struct semaphore_elem, elem)->semaphore);
+	struct semaphore_elem *waiter = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (!heap_empty (&cond->waiters)) {
+		waiter = heap_entry (heap_pop (&cond->waiters),
+				struct semaphore_elem, elem);
+		if (waiter->thread->wait_heap == &cond->waiters)
+			waiter->thread->wait_heap = NULL;
 	}
+	intr_set_level (old_level);
+
+	if (waiter != NULL)
+		sema_up (&waiter->semaphore);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -373,6 +587,6 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
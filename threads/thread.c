@@ -4,6 +4,7 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
@@ -33,6 +34,16 @@ extern int64_t MIN_alarm_time;
    that are ready to run but not actually running. */
 static struct list ready_list;
 
+/* THREAD_READY threads, by virtual runtime, under the completely
+   fair scheduler instead of ready_list. */
+static struct heap cfs_queue;
+
+/* Least virtual runtime run so far. */
+static uint64_t min_vruntime;
+
+/* Number of threads in the run queue. */
+static size_t ready_cnt;
+
 /* 준비 상태 이전의 대기큐입니다. */
 static struct list sleep_list;
 
@@ -48,6 +59,10 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* List of all threads that have not yet exited, linked through
+   `all_elem'. */
+static struct list all_list;
+
 /* Statistics. */
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
@@ -63,6 +78,50 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 bool thread_mlfqs;
 int load_avg;
 
+/* If true, use the completely fair scheduler, which runs the
+   ready thread with the least virtual runtime.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* A thread's virtual runtime advances by CFS_TICK_VRUNTIME per
+   tick at nice 0, and by that times NICE_0_WEIGHT / weight at
+   other nice values.  A thread that wakes up or is created is
+   placed no further than CFS_SLEEPER_CREDIT behind the least
+   virtual runtime run so far, so a long sleep cannot buy it a
+   long run, and it preempts the running thread only if it is
+   more than CFS_WAKEUP_GRAN behind it. */
+#define NICE_0_WEIGHT 1024
+#define CFS_TICK_VRUNTIME (1000000000ULL / TIMER_FREQ)
+#define CFS_SLEEPER_CREDIT (TIME_SLICE * CFS_TICK_VRUNTIME)
+#define CFS_WAKEUP_GRAN CFS_TICK_VRUNTIME
+
+/* Load weight of each nice value from NICE_MIN to NICE_MAX.  Each
+   step of nice is worth about 10% of CPU time against a thread
+   one step away, as in Linux. */
+static const unsigned cfs_weights[NICE_MAX - NICE_MIN + 1] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */  9548,  7620,  6100,  4904,  3906,
+	/*  -5 */  3121,  2501,  1991,  1586,  1277,
+	/*   0 */  1024,   820,   655,   526,   423,
+	/*   5 */   335,   272,   215,   172,   137,
+	/*  10 */   110,    87,    70,    56,    45,
+	/*  15 */    36,    29,    23,    18,    15,
+	/*  20 */    12,
+};
+
+/* load_avg decays by 59/60 each second and gains 1/60 per ready
+   thread. */
+#define LOAD_AVG_DECAY (59 * F / 60)
+#define LOAD_AVG_GAIN (F / 60)
+
+/* Seconds of recent_cpu decay done so far, and the decay
+   coefficients of the last DECAY_HISTORY of them, indexed by
+   second modulo DECAY_HISTORY. */
+#define DECAY_HISTORY 64
+static int64_t mlfqs_epoch;
+static int decay_history[DECAY_HISTORY];
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -71,6 +130,13 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static void mlfqs_catch_up (struct thread *);
+static heap_less_func vruntime_less;
+static void runqueue_push (struct thread *);
+static struct thread *runqueue_pop (void);
+
+/* Returns true if T is the idle thread. */
+#define is_idle(t) ((t) == idle_thread)
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -117,8 +183,10 @@ thread_init (void) {
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
 	list_init (&ready_list);
+	heap_init (&cfs_queue, vruntime_less, NULL);
 	list_init (&sleep_list);
 	list_init (&destruction_req);
+	list_init (&all_list);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
@@ -151,7 +219,7 @@ thread_tick (void) {
 	struct thread *t = thread_current();
 
 	/* Update statistics. */
-	if (t == idle_thread)
+	if (is_idle (t))
 		idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
@@ -160,11 +228,22 @@ thread_tick (void) {
 	else
 		kernel_ticks++;
 
+	if (thread_cfs && !is_idle (t))
+		t->vruntime += CFS_TICK_VRUNTIME * NICE_0_WEIGHT
+			/ cfs_weights[t->nice - NICE_MIN];
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
+/* Adds N timer ticks that passed in the idle thread without a
+   timer interrupt, as in tickless idle, to the statistics. */
+void
+thread_idle_ticks (int64_t n) {
+	idle_ticks += n;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
@@ -224,8 +303,8 @@ thread_create (const char *name, int priority,
 		return TID_ERROR;
 	}
 	t->fd_idx = 2;
-	t->fd_table[0] = 1;
-	t->fd_table[1] = 2;
+	t->fd_table[0] = STDIN_MARKER;
+	t->fd_table[1] = STDOUT_MARKER;
 
 	/* Add to run queue. */
 	thread_unblock (t);
@@ -262,8 +341,18 @@ priority_more (const struct list_elem *a_, const struct list_elem *b_,
 
 void 
 test_max_priority(void) {
+	if (thread_cfs) {
+		struct heap_elem *top = heap_top (&cfs_queue);
+
+		if (top != NULL && !intr_context ()
+				&& heap_entry (top, struct thread, cfs_elem)->vruntime
+				+ CFS_WAKEUP_GRAN < thread_current ()->vruntime)
+			thread_yield ();
+		return;
+	}
+
 	if (!list_empty(&ready_list)) {
-		struct thread *top_pri = list_begin(&ready_list);
+		struct list_elem *top_pri = list_begin(&ready_list);
 		if (!intr_context() && priority_more(top_pri, &thread_current()->elem, NULL))
 		{
 			thread_yield();
@@ -287,7 +376,9 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-  	list_insert_ordered(&ready_list, &t->elem, priority_more, NULL);
+	if (thread_mlfqs)
+		mlfqs_catch_up (t);
+	runqueue_push (t);
 	t->status = THREAD_READY;
 	intr_set_level (old_level);
 }
@@ -355,14 +446,29 @@ thread_exit (void) {
 #ifdef USERPROG
 	process_exit ();
 #endif
+	malloc_drain ();
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	list_remove (&thread_current ()->all_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
 
+/* Invokes FUNC on every thread that has not yet exited, passing
+   along AUX.  Must be called with interrupts off. */
+void
+thread_foreach (thread_action_func *func, void *aux) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&all_list); e != list_end (&all_list);
+			e = list_next (e))
+		func (list_entry (e, struct thread, all_elem), aux);
+}
+
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 void
@@ -373,8 +479,8 @@ thread_yield (void) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
-	if (curr != idle_thread)
-    	list_insert_ordered(&ready_list, &curr->elem, priority_more, NULL);
+	if (!is_idle (curr))
+		runqueue_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
@@ -388,7 +494,7 @@ thread_sleep(int64_t ticks) {
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (!is_idle (curr))
 		curr->wake_up_ticks = ticks;
 		if (MIN_alarm_time > ticks) {
 			MIN_alarm_time = ticks;
@@ -399,55 +505,76 @@ thread_sleep(int64_t ticks) {
 	intr_set_level(old_level);
 }
 
+/* Orders a thread's held locks by the highest priority waiting
+   on each. */
+static bool
+held_lock_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct lock *a = heap_entry (a_, struct lock, held_elem);
+	const struct lock *b = heap_entry (b_, struct lock, held_elem);
+
+	return a->max_priority < b->max_priority;
+}
+
+/* Recomputes the current thread's priority as the greater of its
+   own and the highest priority waiting on any lock it holds. */
 void 
 refresh_priority (void) {
-	thread_current()->priority = thread_current()->original_priority;
+	struct thread *cur = thread_current ();
+	struct heap_elem *top;
+	enum intr_level old_level;
 
-	if (!list_empty(&thread_current()->donations)) {
-		struct thread *front_thread = list_entry (list_begin(&thread_current()->donations), struct thread, donations_elem);
-		if (thread_current()->priority < front_thread->priority) {
-			thread_current()->priority = front_thread->priority;
-		}
+	old_level = intr_disable ();
+	cur->priority = cur->original_priority;
+	top = heap_top (&cur->held_locks);
+	if (top != NULL) {
+		int donated = heap_entry (top, struct lock, held_elem)->max_priority;
+		if (cur->priority < donated)
+			cur->priority = donated;
 	}
+	intr_set_level (old_level);
 }
 
+/* Donates the current thread's priority along the chain of lock
+   holders starting with the lock it is about to wait for.  Each
+   lock on the way records the donation as its new waiter
+   maximum, and each holder is raised to it.  The walk stops as
+   soon as a lock or holder is already at least that high, since
+   everything past it must be too, so it takes time proportional
+   to how far the donation actually reaches, whatever the nesting
+   depth.  Must be called with interrupts off. */
 void 
-donate_priority(void) {
-    struct thread *curr = thread_current(); 
-    struct thread *holder;					
+donate_priority (void) {
+	struct thread *cur = thread_current ();
+	int priority = cur->priority;
+	struct lock *lock;
 
-    int priority = curr->priority;
+	ASSERT (intr_get_level () == INTR_OFF);
 
-    for (int i = 0; i < 8; i++) {
-        if (curr->waiting_lock == NULL) {
-            return;
+	for (lock = cur->waiting_lock; lock != NULL; lock = lock->holder->waiting_lock) {
+		struct thread *holder = lock->holder;
+
+		if (holder == NULL || lock->max_priority >= priority)
+			break;
+		lock->max_priority = priority;
+		heap_update (&holder->held_locks, &lock->held_elem);
+
+		if (holder->priority >= priority)
+			break;
+		holder->priority = priority;
+		synch_priority_changed (holder);
+		if (holder->status == THREAD_READY) {
+			list_remove (&holder->elem);
+			list_insert_ordered (&ready_list, &holder->elem, priority_more, NULL);
 		}
-        holder = curr->waiting_lock->holder;
-        holder->priority = priority;
-        curr = holder;
-    }
-}
-void
-remove_with_lock (struct lock *lock) {
-   struct list_elem *curr_donation_elem = list_begin(&thread_current()->donations);
-
-   while (curr_donation_elem != list_tail(&thread_current()->donations)) {
-      struct thread *curr_donation_thread = list_entry(curr_donation_elem, struct thread, donations_elem);
-      
-      if (curr_donation_thread->waiting_lock == lock) {
-         curr_donation_elem = list_remove(curr_donation_elem);
-      }
-      else {
-         curr_donation_elem = list_next(curr_donation_elem);
-      }
-   }
+	}
 }
 
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
-	if (thread_mlfqs) {
+	if (thread_mlfqs || thread_cfs) {
 		return;
 	}
 
@@ -473,7 +600,8 @@ thread_set_nice (int nice UNUSED) {
 	old_level = intr_disable();
 	t->nice = nice;
 
-	mlfqs_priority(t);
+	if (thread_mlfqs)
+		mlfqs_priority(t);
 	test_max_priority();
 	intr_set_level(old_level);
 }
@@ -516,67 +644,129 @@ thread_get_recent_cpu (void) {
 	return current_cpu;
 }
 
+/* Sets T's priority from its recent_cpu and nice values, clamped
+   to the valid range.  Returns true if the priority changed. */
+static bool
+mlfqs_update_priority (struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (div_mixed (t->recent_cpu, 4))
+		- t->nice * 2;
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	if (priority == t->priority)
+		return false;
+	t->priority = priority;
+	return true;
+}
+
 // recent_cpu와 nice값을 이용하여 priority를 계산
 void mlfqs_priority (struct thread *t) {
-	if (t != idle_thread) {
-		int div_cpu = fp_to_int(div_mixed(t->recent_cpu, 4));
-		int mult_nice = t->nice * 2;
-		t->priority = PRI_MAX - div_cpu - mult_nice;
-	}
-}	
+	if (!is_idle (t))
+		mlfqs_update_priority (t);
+}
+
+/* Applies one second's decay to T's recent_cpu, using decay
+   coefficient COEF. */
+static inline void
+decay_recent_cpu (struct thread *t, int coef) {
+	t->recent_cpu = add_mixed (mult_fp (coef, t->recent_cpu), t->nice);
+}
 
 void mlfqs_recent_cpu (struct thread *t) {
-	if (t != idle_thread) {
+	if (!is_idle (t)) {
 		int mult_load = mult_mixed(load_avg, 2);
-		int mult_load_add = add_mixed(mult_load, 1);
-		int temp = mult_fp(div_fp(mult_load, mult_load_add), t->recent_cpu);
-		t->recent_cpu = add_mixed(temp, t->nice);
+		decay_recent_cpu (t, div_fp (mult_load, add_mixed (mult_load, 1)));
+		t->recent_cpu_epoch = mlfqs_epoch;
 	}
 }
 
+/* Brings the recent_cpu of T, which has been blocked, up to date
+   by applying the decays of the seconds it slept through.
+   mlfqs_recalc() makes sure no thread falls more than
+   DECAY_HISTORY seconds behind, so every decay it needs is still
+   in decay_history[]. */
+static void
+replay_decays (struct thread *t) {
+	int64_t e;
+
+	ASSERT (mlfqs_epoch - t->recent_cpu_epoch <= DECAY_HISTORY);
+
+	for (e = t->recent_cpu_epoch; e < mlfqs_epoch; e++)
+		decay_recent_cpu (t, decay_history[e % DECAY_HISTORY]);
+	t->recent_cpu_epoch = mlfqs_epoch;
+}
+
+/* Brings T, which is about to be unblocked, up to date and
+   recomputes its priority. */
+static void
+mlfqs_catch_up (struct thread *t) {
+	replay_decays (t);
+	mlfqs_update_priority (t);
+}
 
 void mlfqs_load_avg (void) {
-	int a = div_fp(int_to_fp(59), int_to_fp(60));
-	int mult_load = mult_fp(a, load_avg);
-	int ready_threads = list_size(&ready_list);
-	if (thread_current() != idle_thread) {
+	int ready_threads = ready_cnt;
+
+	if (!is_idle (thread_current ())) {
     	ready_threads++;
 	}
-	int b = div_fp(int_to_fp(1), int_to_fp(60));
-	int mult_ready = mult_mixed(b, ready_threads);
-	load_avg = mult_load + mult_ready;
+	load_avg = mult_fp (LOAD_AVG_DECAY, load_avg)
+		+ mult_mixed (LOAD_AVG_GAIN, ready_threads);
 }
 
 void mlfqs_increment (void) {
-	if (thread_current != idle_thread) {
+	if (!is_idle (thread_current ())) {
 		thread_current()->recent_cpu = add_mixed(thread_current()->recent_cpu, 1);
 	}
 }
 
+/* Once per second, decays recent_cpu and recomputes the priority
+   of the running thread and of every ready thread, re-sorting the
+   run queue only if some priority in it changed.  Blocked threads
+   are left alone: the decay coefficient is recorded in
+   decay_history[], and thread_unblock() replays the missed decays
+   when it wakes them.  Only once every DECAY_HISTORY seconds,
+   before the oldest recorded decays are overwritten, are the
+   blocked threads brought up to date here.  Their priorities are
+   left for thread_unblock(), since a blocked thread may sit in a
+   waiter heap ordered by priority. */
 void mlfqs_recalc (void) {
+	int mult_load = mult_mixed (load_avg, 2);
+	int coef = div_fp (mult_load, add_mixed (mult_load, 1));
 	struct thread *t;
 	struct list_elem *e;
-
-	for (e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e)) {
-		t = list_entry(e, struct thread, elem);
-		if (t != NULL) {
-			mlfqs_recent_cpu(t);
-			mlfqs_priority(t);
-		}
-	}
-
-	for (e = list_begin(&sleep_list); e != list_end(&sleep_list); e = list_next(e)) {
-        t = list_entry(e, struct thread, elem);
-		if (t != NULL) {
-        	mlfqs_recent_cpu(t);
-        	mlfqs_priority(t);
+	bool changed = false;
+
+	if (mlfqs_epoch % DECAY_HISTORY == 0)
+		for (e = list_begin (&all_list); e != list_end (&all_list);
+				e = list_next (e)) {
+			t = list_entry (e, struct thread, all_elem);
+			if (t->status == THREAD_BLOCKED && !is_idle (t))
+				replay_decays (t);
 		}
-    }
 
-	t = thread_current();
-	if (t != NULL) {
-   		mlfqs_recent_cpu(t);
-    	mlfqs_priority(t);
+	decay_history[mlfqs_epoch % DECAY_HISTORY] = coef;
+	mlfqs_epoch++;
+
+	for (e = list_begin (&ready_list); e != list_end (&ready_list);
+			e = list_next (e)) {
+		t = list_entry (e, struct thread, elem);
+		if (is_idle (t))
+			continue;
+		decay_recent_cpu (t, coef);
+		t->recent_cpu_epoch = mlfqs_epoch;
+		changed |= mlfqs_update_priority (t);
+	}
+	if (changed)
+		list_sort (&ready_list, priority_more, NULL);
+
+	t = thread_current ();
+	if (!is_idle (t)) {
+		decay_recent_cpu (t, coef);
+		t->recent_cpu_epoch = mlfqs_epoch;
+		mlfqs_update_priority (t);
 	}
 }
 
@@ -612,8 +802,15 @@ idle (void *idle_started_ UNUSED) {
 		   time.
 
 		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-		   7.11.1 "HLT Instruction". */
+		   7.11.1 "HLT Instruction".
+
+		   In tickless mode, the periodic timer tick is stopped
+		   around the halt, so that only a due sleeper or some
+		   other device wakes us up. */
+		timer_idle_enter ();
 		asm volatile ("sti; hlt" : : : "memory");
+		intr_disable ();
+		timer_idle_exit ();
 	}
 }
 
@@ -632,6 +829,8 @@ kernel_thread (thread_func *function, void *aux) {
    NAME. */
 static void
 init_thread (struct thread *t, const char *name, int priority) {
+	enum intr_level old_level;
+
 	ASSERT (t != NULL);
 	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT (name != NULL);
@@ -646,17 +845,27 @@ init_thread (struct thread *t, const char *name, int priority) {
 	/* inversion */
 	t->original_priority = priority;
 	t->waiting_lock = NULL;
-	list_init(&t->donations);
+	heap_init (&t->held_locks, held_lock_less, NULL);
 
 	/* MLFQS*/
 	t->nice = NICE_DEFAULT;
 	t->recent_cpu = RECENT_CPU_DEFAULT;
+	t->recent_cpu_epoch = mlfqs_epoch;
+
+	old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 
 	/* process */
 	list_init(&t->child_list);
 	sema_init(&t->wait_sema, 0);
 	sema_init(&t->fork_sema, 0);
 	sema_init(&t->exit_sema, 0);
+#ifdef USERPROG
+	t->leader = t;
+	list_init (&t->threads);
+	sema_init (&t->threads_done, 0);
+#endif
 
 	/* filesys */
 	// 작동하지 않는 코드, 먼저 수정하셔도 됩니다
@@ -680,10 +889,64 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct thread *t = runqueue_pop ();
+
+	return t != NULL ? t : idle_thread;
+}
+
+/* Orders threads in the CFS run queue: A is less than B if it
+   has run for longer in virtual time, so the heap's top is the
+   thread that is furthest behind. */
+static bool
+vruntime_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, cfs_elem);
+	const struct thread *b = heap_entry (b_, struct thread, cfs_elem);
+
+	return a->vruntime > b->vruntime;
+}
+
+/* Adds T to the run queue, in priority order, or by virtual
+   runtime under the completely fair scheduler.  Interrupts must
+   be off. */
+static void
+runqueue_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_cfs) {
+		uint64_t floor = min_vruntime > CFS_SLEEPER_CREDIT
+			? min_vruntime - CFS_SLEEPER_CREDIT : 0;
+
+		if (t->vruntime < floor)
+			t->vruntime = floor;
+		heap_push (&cfs_queue, &t->cfs_elem);
+	} else
+		list_insert_ordered (&ready_list, &t->elem, priority_more, NULL);
+	ready_cnt++;
+}
+
+/* Removes and returns the highest-priority thread in the run
+   queue, or under the completely fair scheduler the one with the
+   least virtual runtime, or a null pointer if it is empty.
+   Interrupts must be off. */
+static struct thread *
+runqueue_pop (void) {
+	struct thread *t = NULL;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_cfs) {
+		if (!heap_empty (&cfs_queue)) {
+			t = heap_entry (heap_pop (&cfs_queue), struct thread, cfs_elem);
+			ready_cnt--;
+			if (t->vruntime > min_vruntime)
+				min_vruntime = t->vruntime;
+		}
+	} else if (!list_empty (&ready_list)) {
+		t = list_entry (list_pop_front (&ready_list), struct thread, elem);
+		ready_cnt--;
+	}
+	return t;
 }
 
 /* Use iretq to launch the thread */
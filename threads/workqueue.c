@@ -0,0 +1,318 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of worker threads in the pool. */
+#define WORKER_CNT 4
+
+/* Items waiting for a worker, in the order they were queued,
+   across all queues. */
+static struct list pending_list;
+
+/* Items waiting for their delay to expire, soonest first. */
+static struct list delayed_list;
+
+/* Idle workers sleep here.  Each up hands the semaphore to
+   exactly one of them. */
+static struct semaphore work_ready;
+
+/* Number of workers asleep on `work_ready' that nobody has
+   woken yet. */
+static int idle_workers;
+
+struct workqueue system_wq;
+
+/* All of the state above is shared with interrupt handlers, so
+   it is protected by turning interrupts off. */
+
+/* A thread waiting in workqueue_flush(). */
+struct flusher {
+	struct list_elem elem;      /* Element in queue's `flushers'. */
+	struct semaphore sema;      /* Upped when the queue is drained. */
+};
+
+static thread_func worker;
+static void wake_flushers (struct workqueue *);
+
+/* Initializes the work pool's lists and the system workqueue.
+   Must be called before the timer interrupt is enabled. */
+void
+work_pool_init (void) {
+	list_init (&pending_list);
+	list_init (&delayed_list);
+	sema_init (&work_ready, 0);
+	workqueue_init (&system_wq, "events", WORKER_CNT);
+}
+
+/* Starts the worker threads.  Must be called after
+   thread_start(). */
+void
+work_pool_start (void) {
+	int i;
+
+	for (i = 0; i < WORKER_CNT; i++) {
+		char name[16];
+
+		snprintf (name, sizeof name, "kworker/%d", i);
+		thread_create (name, PRI_DEFAULT, worker, NULL);
+	}
+}
+
+/* Initializes WQ as a queue named NAME that lets at most
+   MAX_ACTIVE of its items run at once. */
+void
+workqueue_init (struct workqueue *wq, const char *name, int max_active) {
+	ASSERT (wq != NULL);
+	ASSERT (max_active > 0);
+
+	wq->name = name;
+	wq->max_active = max_active;
+	wq->active = 0;
+	wq->pending = 0;
+	list_init (&wq->flushers);
+}
+
+/* Waits until every item queued on WQ so far has run.  Items
+   still waiting out a delay are not waited for.  Items queued
+   while waiting may or may not be. */
+void
+workqueue_flush (struct workqueue *wq) {
+	struct flusher f;
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	if (wq->pending + wq->active > 0) {
+		sema_init (&f.sema, 0);
+		list_push_back (&wq->flushers, &f.elem);
+		sema_down (&f.sema);
+	}
+	intr_set_level (old_level);
+}
+
+/* Initializes W to run FUNC (AUX) whenever it is queued. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->wq = NULL;
+	w->state = WORK_IDLE;
+}
+
+/* Wakes one idle worker, if there is one. */
+static void
+kick_worker (void) {
+	if (idle_workers > 0) {
+		idle_workers--;
+		sema_up (&work_ready);
+	}
+}
+
+/* Puts W, which is not on any list, at the end of the pending
+   list of WQ.  Interrupts must be off. */
+static void
+make_pending (struct workqueue *wq, struct work *w) {
+	w->wq = wq;
+	w->state = WORK_PENDING;
+	list_push_back (&pending_list, &w->elem);
+	wq->pending++;
+	if (wq->active < wq->max_active)
+		kick_worker ();
+}
+
+/* Queues W on WQ to be run by a worker as soon as WQ's limit
+   allows.  Returns true if W was queued, false if it was already
+   queued or delayed.  W may be queued again once a worker has
+   started running it.  May be called from an interrupt
+   handler. */
+bool
+queue_work (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (w != NULL);
+
+	old_level = intr_disable ();
+	if (w->state == WORK_IDLE) {
+		make_pending (wq, w);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Returns true if delayed item A is due before delayed item
+   B. */
+static bool
+due_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct work *a = list_entry (a_, struct work, elem);
+	const struct work *b = list_entry (b_, struct work, elem);
+
+	return a->due < b->due;
+}
+
+/* Queues W on WQ once TICKS timer ticks have passed, or at once
+   if TICKS is not positive.  Returns true if W was queued, false
+   if it was already queued or delayed.  May be called from an
+   interrupt handler. */
+bool
+queue_delayed_work (struct workqueue *wq, struct work *w, int64_t ticks) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (w != NULL);
+
+	if (ticks <= 0)
+		return queue_work (wq, w);
+
+	old_level = intr_disable ();
+	if (w->state == WORK_IDLE) {
+		w->wq = wq;
+		w->due = timer_ticks () + ticks;
+		w->state = WORK_DELAYED;
+		list_insert_ordered (&delayed_list, &w->elem, due_less, NULL);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Takes W off its queue if it is queued or delayed and no worker
+   has started it yet.  Returns true if W was taken off, false if
+   it was not queued.  Does not wait for a running W to
+   finish. */
+bool
+cancel_work (struct work *w) {
+	enum intr_level old_level;
+	bool canceled = true;
+
+	ASSERT (w != NULL);
+
+	old_level = intr_disable ();
+	switch (w->state) {
+		case WORK_PENDING:
+			w->wq->pending--;
+			list_remove (&w->elem);
+			wake_flushers (w->wq);
+			break;
+		case WORK_DELAYED:
+			list_remove (&w->elem);
+			break;
+		case WORK_IDLE:
+			canceled = false;
+			break;
+	}
+	w->state = WORK_IDLE;
+	intr_set_level (old_level);
+	return canceled;
+}
+
+/* Returns the tick at which the earliest delayed item is due,
+   or INT64_MAX if there is none.  Interrupts must be off. */
+int64_t
+work_pool_deadline (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (list_empty (&delayed_list))
+		return INT64_MAX;
+	return list_entry (list_front (&delayed_list), struct work, elem)->due;
+}
+
+/* Moves every delayed item due at or before TICKS to its queue.
+   Called by the timer with interrupts off. */
+void
+work_pool_timer (int64_t ticks) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&delayed_list)) {
+		struct work *w = list_entry (list_front (&delayed_list),
+				struct work, elem);
+
+		if (w->due > ticks)
+			break;
+		list_pop_front (&delayed_list);
+		make_pending (w->wq, w);
+	}
+}
+
+/* Removes and returns the oldest pending item whose queue is
+   below its limit, or a null pointer if there is none, and
+   counts it as running.  Interrupts must be off. */
+static struct work *
+take_work (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&pending_list); e != list_end (&pending_list);
+			e = list_next (e)) {
+		struct work *w = list_entry (e, struct work, elem);
+		struct workqueue *wq = w->wq;
+
+		if (wq->active < wq->max_active) {
+			list_remove (e);
+			w->state = WORK_IDLE;
+			wq->pending--;
+			wq->active++;
+			return w;
+		}
+	}
+	return NULL;
+}
+
+/* Wakes every thread flushing WQ if WQ has drained.  Interrupts
+   must be off. */
+static void
+wake_flushers (struct workqueue *wq) {
+	if (wq->pending + wq->active > 0)
+		return;
+	while (!list_empty (&wq->flushers)) {
+		struct flusher *f = list_entry (list_pop_front (&wq->flushers),
+				struct flusher, elem);
+
+		sema_up (&f->sema);
+	}
+}
+
+/* Worker thread.  Runs pending items one at a time, sleeping
+   whenever none of them may run. */
+static void
+worker (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level;
+		struct workqueue *wq;
+		struct work *w;
+		work_func *func;
+		void *func_aux;
+
+		old_level = intr_disable ();
+		while ((w = take_work ()) == NULL) {
+			idle_workers++;
+			sema_down (&work_ready);
+		}
+
+		/* Once it is running, W belongs to its owner again, who
+		   may queue it anew or free it, so we copy out what we
+		   need before turning interrupts back on. */
+		wq = w->wq;
+		func = w->func;
+		func_aux = w->aux;
+		intr_set_level (old_level);
+
+		func (func_aux);
+
+		old_level = intr_disable ();
+		wq->active--;
+		wake_flushers (wq);
+		intr_set_level (old_level);
+	}
+}
@@ -0,0 +1,143 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Futex wait queues.
+
+   A futex is named by the address space it lives in and its
+   user virtual address.  The page table of the process stands
+   for the address space, so two threads that share one see the
+   same futex at the same address, while the same address in two
+   different processes names two different futexes.
+
+   Sleepers are kept in a fixed table of buckets chosen by
+   hashing that key, each with its own lock and list of waiters,
+   so futexes that land in different buckets never contend.  A
+   waiter lives on the stack of the sleeping thread for the
+   duration of the wait. */
+
+/* Number of buckets.  Must be a power of 2. */
+#define FUTEX_BUCKETS 64
+
+/* A thread sleeping on a futex. */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in bucket's `waiters'. */
+	uint64_t *pml4;             /* Address space of the futex. */
+	int *uaddr;                 /* User address of the futex. */
+	struct semaphore sema;      /* Upped to wake the thread. */
+};
+
+/* One bucket of the table. */
+struct futex_bucket {
+	struct lock lock;           /* Protects `waiters'. */
+	struct list waiters;        /* List of struct futex_waiter. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* Initializes the futex table. */
+void
+futex_init (void) {
+	size_t i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		lock_init (&buckets[i].lock);
+		list_init (&buckets[i].waiters);
+	}
+}
+
+/* Returns the bucket for the futex at UADDR in address space
+   PML4. */
+static struct futex_bucket *
+bucket_for (uint64_t *pml4, int *uaddr) {
+	uintptr_t key[2] = { (uintptr_t) pml4, (uintptr_t) uaddr };
+
+	return &buckets[hash_bytes (key, sizeof key) & (FUTEX_BUCKETS - 1)];
+}
+
+/* If the int at UADDR, which the caller has validated, still
+   equals VAL, puts the running thread to sleep until a
+   futex_wake() on the same futex picks it.  Returns 0 once
+   woken, or -1 without sleeping if the value differs or the
+   process is exiting.
+
+   The value is read with the bucket lock held, and wakers take
+   the same lock, so a wake issued after the program changed the
+   value cannot slip in between the read and the sleep.  The
+   same goes for futex_wake_all(). */
+int
+futex_wait (int *uaddr, int val) {
+	struct thread *t = thread_current ();
+	struct futex_bucket *b = bucket_for (t->pml4, uaddr);
+	struct futex_waiter w;
+
+	lock_acquire (&b->lock);
+	if (t->leader->exiting || *(volatile int *) uaddr != val) {
+		lock_release (&b->lock);
+		return -1;
+	}
+	w.pml4 = t->pml4;
+	w.uaddr = uaddr;
+	sema_init (&w.sema, 0);
+	list_push_back (&b->waiters, &w.elem);
+	lock_release (&b->lock);
+
+	sema_down (&w.sema);
+	return 0;
+}
+
+/* Wakes up to CNT threads sleeping on the futex at UADDR in the
+   running thread's address space, longest sleeper first.
+   Returns the number of threads woken. */
+int
+futex_wake (int *uaddr, int cnt) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	struct futex_bucket *b = bucket_for (pml4, uaddr);
+	struct list_elem *e;
+	int woken = 0;
+
+	lock_acquire (&b->lock);
+	for (e = list_begin (&b->waiters);
+			woken < cnt && e != list_end (&b->waiters);) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		if (w->pml4 == pml4 && w->uaddr == uaddr) {
+			e = list_remove (e);
+			sema_up (&w->sema);
+			woken++;
+		} else
+			e = list_next (e);
+	}
+	lock_release (&b->lock);
+	return woken;
+}
+
+/* Wakes every thread sleeping on any futex in address space
+   PML4, so that the threads of an exiting process reach their
+   next system call.  The caller must already have marked the
+   process as exiting. */
+void
+futex_wake_all (uint64_t *pml4) {
+	size_t i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		struct futex_bucket *b = &buckets[i];
+		struct list_elem *e;
+
+		lock_acquire (&b->lock);
+		for (e = list_begin (&b->waiters); e != list_end (&b->waiters);) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			if (w->pml4 == pml4) {
+				e = list_remove (e);
+				sema_up (&w->sema);
+			} else
+				e = list_next (e);
+		}
+		lock_release (&b->lock);
+	}
+}
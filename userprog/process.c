@@ -5,14 +5,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vdso.h>
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/vdso.h"
+#include "devices/input.h"
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/pipe.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -27,6 +35,9 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void start_thread (void *);
+static void exit_thread (void);
+static void reap_threads (void);
 /*project 2 and 3*/
 extern struct lock file_lock;
 /* General process initializer for initd and other process. */
@@ -114,6 +125,12 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 		return true;
 	}
 
+	/* The child already has a vDSO page of its own, which the
+	   parent's must not overwrite. */
+	if (va == (void *) VDSO_BASE) {
+		return true;
+	}
+
 	/* 2. Resolve VA from the parent's page map level 4. */
 	parent_page = pml4_get_page(parent->pml4, va);
 	if (parent_page == NULL) {
@@ -166,9 +183,11 @@ __do_fork (void *aux) {
 		goto error;
 
 	process_activate (current);
+	if (!vdso_map (current))
+		goto error;
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+	if (!supplemental_page_table_copy (&current->spt, &parent->leader->spt))
 		goto error;
 #else
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
@@ -180,19 +199,31 @@ __do_fork (void *aux) {
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
-	if (parent->fd_idx == FDCOUNT_LIMIT) {
+	if (parent->leader->fd_idx == FDCOUNT_LIMIT) {
 		goto error;
 	}
 
 	for (int i = 0; i < FDCOUNT_LIMIT; i++) {
 		struct file *file = parent->fd_table[i];
 		if (file == NULL) continue;
-		if (file > 2) {
-			file = file_duplicate(file);
+		if (file != STDIN_MARKER && file != STDOUT_MARKER) {
+			/* Descriptors shared through dup2() stay shared. */
+			int j;
+			for (j = 0; j < i; j++) {
+				if (parent->fd_table[j] == file) break;
+			}
+			if (j < i) {
+				file = file_dup(current->fd_table[j]);
+			} else if ((file = file_duplicate(file)) == NULL) {
+				goto error;
+			}
 		}
 		current->fd_table[i] = file;
 	}
-	current->fd_idx = parent->fd_idx;
+	current->fd_idx = parent->leader->fd_idx;
+	/* The ring lives in user memory, which the child now has a
+	   copy of at the same address. */
+	current->ring = parent->ring;
 	sema_up(&current->fork_sema);
 
 	// process_init ();
@@ -209,6 +240,12 @@ error:
  * Returns -1 on fail. */
 int
 process_exec (void *f_name) {
+	/* Only the main thread may replace the program, and only once
+	   it is the last thread left. */
+	if (thread_current ()->leader != thread_current ())
+		return -1;
+	reap_threads ();
+
 	char *file_name = (char *)palloc_get_page(PAL_ZERO);
 	strlcpy(file_name, (char *)f_name, strlen(f_name) + 1);
 	bool success;
@@ -223,6 +260,10 @@ process_exec (void *f_name) {
 
 	/* We first kill the current context */
 	process_cleanup ();
+	thread_current ()->ring = NULL;
+#ifdef VM
+	supplemental_page_table_init (&thread_current ()->spt);
+#endif
 
 	/* project 2: argument passing */
     char *argv[MAX_ARGS];
@@ -270,18 +311,289 @@ process_wait (tid_t child_tid) {
 	 * XXX:       to add infinite loop here before
 	 * XXX:       implementing the process_wait. */
 
+	struct thread *curr = thread_current ();
 	struct thread *child;
+	enum intr_level old_level;
+	bool interrupted;
+
 	if (!(child = get_child_thread(child_tid))) {
 		return -1;
 	}
 
+	/* Let process_interrupt() find us, unless the process is
+	   already exiting and it has come and gone. */
+	old_level = intr_disable ();
+	if (curr->leader->exiting) {
+		intr_set_level (old_level);
+		return -1;
+	}
+	curr->wait_child = child;
+	intr_set_level (old_level);
+
 	sema_down (&child->wait_sema);
+
+	old_level = intr_disable ();
+	interrupted = curr->wait_child == NULL;
+	curr->wait_child = NULL;
+	intr_set_level (old_level);
+	if (interrupted)
+		return -1;
+
 	list_remove (&child->child_elem);
 	int exit_status = child->exit_status;
 	sema_up (&child->exit_sema);
 	return exit_status;
 }
 
+/* Arguments passed to start_thread(). */
+struct thread_start {
+	struct thread *leader;              /* Main thread of the process. */
+	struct intr_frame if_;              /* User context to start in. */
+	struct semaphore started;           /* Upped once it has started. */
+};
+
+/* Starts a new thread in the running process that enters user
+   code at ENTRY, with ARG0 and ARG1 as its first two arguments,
+   on the user stack whose top is STACK.  Returns the new
+   thread's id, or TID_ERROR if the thread cannot be created or
+   the process is exiting. */
+tid_t
+process_create_thread (uintptr_t entry, uint64_t arg0, uint64_t arg1,
+		uintptr_t stack) {
+	struct thread *leader = thread_current ()->leader;
+	struct thread_start start;
+	enum intr_level old_level;
+	tid_t tid;
+
+	memset (&start.if_, 0, sizeof start.if_);
+	start.if_.ds = start.if_.es = start.if_.ss = SEL_UDSEG;
+	start.if_.cs = SEL_UCSEG;
+	start.if_.eflags = FLAG_IF | FLAG_MBS;
+	start.if_.rip = entry;
+	start.if_.R.rdi = arg0;
+	start.if_.R.rsi = arg1;
+	/* Enter as if called: on an aligned stack, less the return
+	   address. */
+	start.if_.rsp = (stack & ~(uintptr_t) 0xf) - sizeof (void *);
+	start.leader = leader;
+	sema_init (&start.started, 0);
+
+	/* Count the thread now, so that the main thread will not tear
+	   the process down under it. */
+	old_level = intr_disable ();
+	if (leader->exiting) {
+		intr_set_level (old_level);
+		return TID_ERROR;
+	}
+	leader->thread_cnt++;
+	intr_set_level (old_level);
+
+	tid = thread_create (leader->name, PRI_DEFAULT, start_thread, &start);
+	if (tid == TID_ERROR) {
+		old_level = intr_disable ();
+		if (--leader->thread_cnt == 0)
+			sema_up (&leader->threads_done);
+		intr_set_level (old_level);
+		return TID_ERROR;
+	}
+	sema_down (&start.started);
+	return tid;
+}
+
+/* A thread function that joins the new thread to its process
+   and enters user code. */
+static void
+start_thread (void *aux) {
+	struct thread_start *start = aux;
+	struct thread *curr = thread_current ();
+	struct thread *leader = start->leader;
+	struct intr_frame if_;
+	enum intr_level old_level;
+
+	memcpy (&if_, &start->if_, sizeof if_);
+
+	/* thread_create() gave us a descriptor table of our own. */
+	palloc_free_multiple (curr->fd_table, FDT_PAGES);
+	curr->fd_table = leader->fd_table;
+	curr->pml4 = leader->pml4;
+	curr->vdso = leader->vdso;
+	curr->leader = leader;
+	process_activate (curr);
+
+	/* Move from our creator's children to the process's threads,
+	   where any of its threads may join us.  The creator waits
+	   for us, so its list holds still.  If the process is already
+	   exiting, nobody will join us. */
+	old_level = intr_disable ();
+	list_remove (&curr->child_elem);
+	if (leader->exiting)
+		sema_up (&curr->exit_sema);
+	else
+		list_push_back (&leader->threads, &curr->child_elem);
+	intr_set_level (old_level);
+
+	sema_up (&start->started);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* Waits for thread TID of the running process to exit.  Returns
+   0 once it has, or -1 at once if TID is not a thread of the
+   process other than its main thread and the caller, or has
+   already been joined. */
+int
+process_join_thread (tid_t tid) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	struct thread *t = NULL;
+	struct list_elem *e;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	for (e = list_begin (&leader->threads); e != list_end (&leader->threads);
+			e = list_next (e)) {
+		struct thread *cand = list_entry (e, struct thread, child_elem);
+
+		if (cand->tid == tid && cand != curr) {
+			t = cand;
+			list_remove (e);
+			break;
+		}
+	}
+	intr_set_level (old_level);
+	if (t == NULL)
+		return -1;
+
+	/* Once off the list, T waits for us alone before it goes. */
+	sema_down (&t->wait_sema);
+	sema_up (&t->exit_sema);
+	return 0;
+}
+
+/* Ends the running thread, which is not the main thread of its
+   process.  The process's resources belong to the main thread;
+   this thread only lets go of them. */
+static void
+exit_thread (void) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	enum intr_level old_level;
+
+	stdout_flush ();
+	free (curr->stdout_buf);
+	curr->stdout_buf = NULL;
+
+	/* Leave the shared page table before the main thread can
+	   destroy it, in the same order as process_cleanup(). */
+	curr->fd_table = NULL;
+	curr->vdso = NULL;
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+
+	/* Wait to be joined, or for the main thread to give up on
+	   that because the process is exiting. */
+	sema_up (&curr->wait_sema);
+	sema_down (&curr->exit_sema);
+
+	/* The main thread may go as soon as the count drops, so this
+	   is the last we see of it. */
+	old_level = intr_disable ();
+	if (--leader->thread_cnt == 0)
+		sema_up (&leader->threads_done);
+	intr_set_level (old_level);
+}
+
+/* Wakes T if it is a thread of the process whose main thread is
+   LEADER_ and is sleeping in process_wait().  The up it leaves on
+   the child's wait_sema stands in for the one the child has not
+   made yet; process_wait() takes it back.  Interrupts must be
+   off. */
+static void
+interrupt_wait (struct thread *t, void *leader_) {
+	struct thread *leader = leader_;
+
+	if (t->leader == leader && t->wait_child != NULL) {
+		sema_up (&t->wait_child->wait_sema);
+		t->wait_child = NULL;
+	}
+}
+
+/* Wakes every thread of the process whose main thread is LEADER
+   from any sleep that it may cut short because the process is
+   exiting: futex waits, wait(), and reads and writes on pipes and
+   the console.  LEADER->exiting must already be set, so that the
+   woken threads give up instead of going back to sleep. */
+void
+process_interrupt (struct thread *leader) {
+	enum intr_level old_level;
+	int fd;
+
+	ASSERT (leader->exiting);
+
+	futex_wake_all (leader->pml4);
+	input_interrupt ();
+
+	old_level = intr_disable ();
+	thread_foreach (interrupt_wait, leader);
+	intr_set_level (old_level);
+
+	/* Hold a reference while we are in the pipe, since another
+	   thread may close the descriptor under us. */
+	for (fd = 0; fd < FDCOUNT_LIMIT; fd++) {
+		struct file *f;
+
+		old_level = intr_disable ();
+		f = leader->fd_table[fd];
+		if (f == NULL || f == STDIN_MARKER || f == STDOUT_MARKER
+				|| file_get_pipe (f, NULL) == NULL)
+			f = NULL;
+		else
+			file_dup (f);
+		intr_set_level (old_level);
+
+		if (f != NULL) {
+			pipe_interrupt (file_get_pipe (f, NULL));
+			file_close (f);
+		}
+	}
+}
+
+/* Makes every other thread of the running process, which must be
+   its main thread, exit at its next system call, and waits until
+   all of them are gone. */
+static void
+reap_threads (void) {
+	struct thread *curr = thread_current ();
+	bool exiting = curr->exiting;
+	enum intr_level old_level;
+
+	ASSERT (curr->leader == curr);
+
+	if (curr->thread_cnt == 0)
+		return;
+
+	curr->exiting = true;
+	process_interrupt (curr);
+
+	old_level = intr_disable ();
+	/* Nobody is left to join the threads that are not already
+	   being joined. */
+	while (!list_empty (&curr->threads)) {
+		struct thread *t = list_entry (list_pop_front (&curr->threads),
+				struct thread, child_elem);
+
+		sema_up (&t->exit_sema);
+	}
+	while (curr->thread_cnt > 0)
+		sema_down (&curr->threads_done);
+	/* Drop any up left over from a count that dropped to 0 while
+	   we were not waiting. */
+	sema_init (&curr->threads_done, 0);
+	/* Undo our mark if we are only making way for exec(). */
+	curr->exiting = exiting;
+	intr_set_level (old_level);
+}
+
 /* Exit the process. This function is called by thread_exit (). */
 void
 process_exit (void) {
@@ -290,11 +602,23 @@ process_exit (void) {
 	 * TODO: Implement process termination message (see
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
-	for (int i = 2; i < FDCOUNT_LIMIT; i++) {
+	if (curr->leader != curr) {
+		exit_thread ();
+		return;
+	}
+	reap_threads ();
+
+	/* Descriptors 0 and 1 may have been dup2()ed over; close()
+	   leaves the console markers alone. */
+	for (int i = 0; i < FDCOUNT_LIMIT; i++) {
 		close(i);
 	}
 	palloc_free_multiple(curr->fd_table, FDT_PAGES);
 
+	stdout_flush ();
+	free (curr->stdout_buf);
+	curr->stdout_buf = NULL;
+
 	file_close(curr->running);
 
 	process_cleanup ();
@@ -317,6 +641,8 @@ process_cleanup (void) {
 	 * to the kernel-only page directory. */
 	pml4 = curr->pml4;
 	if (pml4 != NULL) {
+		vdso_unmap (curr);
+
 		/* Correct ordering here is crucial.  We must set
 		 * cur->pagedir to NULL before switching page directories,
 		 * so that a timer interrupt can't switch back to the
@@ -339,6 +665,9 @@ process_activate (struct thread *next) {
 
 	/* Set thread's kernel stack for use in processing interrupts. */
 	tss_update (next);
+
+	/* The vDSO page only follows the timer while its process runs. */
+	vdso_update (next, timer_ticks ());
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -419,6 +748,8 @@ load (const char *file_name, struct intr_frame *if_) {
 	if (t->pml4 == NULL){
 		goto done;}
 	process_activate (thread_current ());
+	if (!vdso_map (t))
+		goto done;
 
 	/* Open executable file. */
 	lock_acquire(&file_lock);
@@ -694,7 +1025,7 @@ lazy_load_segment (struct page *page, void *aux) {
 	/* Load this page. */
 	if(file_read(file, page->frame->kva, page_read_bytes) != (int) page_read_bytes) {
 		palloc_free_page(page->frame->kva);
-		free(aux);
+		kmem_cache_free(load_info_cachep, aux);
 		return false;
 	}
 
@@ -703,7 +1034,7 @@ lazy_load_segment (struct page *page, void *aux) {
 		memset(page->frame->kva + page_read_bytes, 0, page_zero_bytes);
 	}
 	if(page_get_type(page)!=VM_FILE) {
-		free(aux);
+		kmem_cache_free(load_info_cachep, aux);
 	}
 	
 	return true;
@@ -739,7 +1070,9 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct load_info* aux = malloc(sizeof(struct load_info));
+		struct load_info* aux = kmem_cache_alloc(load_info_cachep);
+		if (aux == NULL)
+			return false;
 		// insert the given arguments
 		aux->file = file;
 		aux->ofs = ofs;
@@ -1,16 +1,26 @@
 #include <debug.h>
 #include "userprog/process.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
+#include "threads/malloc.h"
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
+#include "devices/input.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
+#include "filesys/pipe.h"
+#include "userprog/futex.h"
 #include "vm/vm.h"
+#include <futex.h>
+#include <iovec.h>
+#include <syscall-ring.h>
+#include <vdso.h>
 
 
 void syscall_entry (void);
@@ -44,6 +54,7 @@ syscall_init (void) {
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
 	lock_init(&file_lock);
+	futex_init();
 }
 
 void check_address(void *addr) {
@@ -56,9 +67,9 @@ void check_address(void *addr) {
 
 	#ifdef VM
 	//printf("[check addr] start\n");
-	if(spt_find_page(&t->spt, addr)) {
+	if(spt_find_page(&t->leader->spt, addr)) {
 		//printf("[check addr] page is found in spt\n");
-		struct page* p = spt_find_page(&t->spt, addr);
+		struct page* p = spt_find_page(&t->leader->spt, addr);
 		enum vm_type page_type = page_get_type(p);
 		//printf("[check addr] passed page type: %d\n",page_type);
 
@@ -68,7 +79,7 @@ void check_address(void *addr) {
 		//printf("[check addr] passed page addr: %p / frame kva: %p \n", p->va, p->frame->kva);
 
 	}
-	if(spt_find_page(&t->spt, addr) == NULL) {
+	if(spt_find_page(&t->leader->spt, addr) == NULL) {
 		//printf("[check addr] fail in 3\n");
 		exit(-1);
 	}
@@ -92,7 +103,10 @@ void validate_buffer(void* buffer, size_t size, bool is_writable) {
 		exit(-1);
 	}
 
-	if (buffer<= USER_STACK && buffer>=thread_current()->intr_rsp) {
+	/* Only the main thread runs on the growable stack; other
+	   threads' stacks are ordinary pages in the SPT. */
+	if (thread_current()->leader == thread_current()
+			&& buffer<= USER_STACK && buffer>=thread_current()->intr_rsp) {
 		//printf("[validate_buffer] case 2\n");
 		return;
 	}
@@ -108,7 +122,7 @@ void validate_buffer(void* buffer, size_t size, bool is_writable) {
 		}
 
 		//check_address(addr);
-		struct page* traget_page= spt_find_page(&thread_current()->spt, addr);
+		struct page* traget_page= spt_find_page(&thread_current()->leader->spt, addr);
 		//printf("[validate buffer] traget_page->writable: %d \n", traget_page->writable);
 
 		if(traget_page == NULL) {
@@ -129,35 +143,60 @@ void validate_buffer(void* buffer, size_t size, bool is_writable) {
 	}
 	}
 
+/* The descriptor table and its search hint belong to the main
+   thread, and the other threads of the process change them too,
+   so slots are claimed and released with interrupts off. */
 int add_file_to_fd_table (struct file *file) {
-	struct thread *t = thread_current();
+	struct thread *t = thread_current()->leader;
 	struct file **fdt = t->fd_table;
+	enum intr_level old_level = intr_disable();
 	int fd = t->fd_idx;
 	while (t->fd_table[fd] != NULL) {
 		if (fd >= FDCOUNT_LIMIT) {
 			t->fd_idx = FDCOUNT_LIMIT;
+			intr_set_level(old_level);
 			return -1;
 		}
 		fd++;
 	}
 	t->fd_idx = fd;
 	fdt[fd] = file;
+	intr_set_level(old_level);
 	return fd;
 }
 
 void halt(void) {
+	/* Output still buffered would be lost at power off. */
+	stdout_flush();
 	power_off();
 }
 
+/* Ends the process with STATUS.  In a process with several
+   threads only the first exit() counts; the calling thread ends
+   at once and the others at their next system call. */
 void exit (int status) {
-	thread_current()->exit_status = status;
-	printf("%s: exit(%d)\n", thread_name(), thread_current()->exit_status);
+	struct thread *leader = thread_current()->leader;
+	stdout_flush();
+
+	enum intr_level old_level = intr_disable();
+	bool first = !leader->exiting;
+	leader->exiting = true;
+	intr_set_level(old_level);
+
+	if (first) {
+		leader->exit_status = status;
+		printf("%s: exit(%d)\n", leader->name, leader->exit_status);
+		/* Sleepers would otherwise never reach a system call. */
+		process_interrupt(leader);
+	}
 	thread_exit();
 }
 
-tid_t fork (const char *thread_name, int (*f)(int)) {
+tid_t fork (const char *thread_name, struct intr_frame *if_) {
 	check_address(thread_name);
-	return process_fork(thread_name, f);
+	/* Keep the parent's pending output ahead of the child's. */
+	stdout_flush();
+	return process_fork(thread_name, if_);
 }
 
 int exec (const char *file) {
@@ -206,8 +245,126 @@ int open (const char *file) {
 	return fd;
 }
 
+/* Returns the on-disk file open as FD, or NULL if FD is not open
+   or stands for the console or a pipe, none of which has a size
+   or a position. */
+static struct file *get_disk_file (int fd) {
+	struct file *f = get_file_from_fd_table(fd);
+	if (f == NULL || f == STDIN_MARKER || f == STDOUT_MARKER
+			|| file_get_pipe(f, NULL) != NULL) {
+		return NULL;
+	}
+	return f;
+}
+
 int filesize (int fd) {
-	return file_length(get_file_from_fd_table(fd));
+	struct file *f = get_disk_file(fd);
+	if (f == NULL) {
+		return -1;
+	}
+	return file_length(f);
+}
+
+/* Reads up to LENGTH bytes of keyboard input into an already
+   validated BUFFER, stopping after the first newline.  Gives up
+   with -1 if the process starts exiting while we wait. */
+static int read_stdin (void *buffer, unsigned length) {
+	const bool *exiting = &thread_current()->leader->exiting;
+	int bytesRead = 0;
+	/* Show any prompt before waiting for input. */
+	stdout_flush();
+	for (int i = 0; i < length; i++) {
+		int c = input_getc_until(exiting);
+		if (c == -1)
+			return -1;
+		((char *)buffer)[i] = c;
+		bytesRead++;
+
+		if (c == '\n') break;
+	}
+	return bytesRead;
+}
+
+/* Reads LENGTH bytes from F, which may be the console or a pipe,
+   into an already validated BUFFER. */
+static int read_file (struct file *f, void *buffer, unsigned length) {
+	bool writer;
+	struct pipe *p;
+	int bytesRead;
+
+	if (f == STDIN_MARKER) {
+		return read_stdin(buffer, length);
+	} else if (f == STDOUT_MARKER) {
+		return -1;
+	} else if ((p = file_get_pipe(f, &writer)) != NULL) {
+		return writer ? -1 : pipe_read(p, buffer, length);
+	}
+
+	lock_acquire(&file_lock);
+	bytesRead = file_read(f, buffer, length);
+	lock_release(&file_lock);
+	return bytesRead;
+}
+
+/* Size of a process's console output buffer. */
+#define STDOUT_BUFSIZE 256
+
+/* Writes out the console output the current process has
+   buffered, if any. */
+void stdout_flush (void) {
+	struct thread *t = thread_current();
+	if (t->stdout_len > 0) {
+		putbuf(t->stdout_buf, t->stdout_len);
+		t->stdout_len = 0;
+	}
+}
+
+/* Collects console output in a per-process buffer and passes it
+   to putbuf() when a line is complete or the buffer fills, so
+   the console lock is taken once per line instead of once per
+   write().  Writes too large for the buffer go straight out. */
+static void write_stdout (const char *buffer, unsigned length) {
+	struct thread *t = thread_current();
+
+	if (t->stdout_buf == NULL) {
+		t->stdout_buf = malloc(STDOUT_BUFSIZE);
+	}
+	if (t->stdout_buf == NULL || length >= STDOUT_BUFSIZE) {
+		stdout_flush();
+		putbuf(buffer, length);
+		return;
+	}
+
+	if (t->stdout_len + length > STDOUT_BUFSIZE) {
+		stdout_flush();
+	}
+	memcpy(t->stdout_buf + t->stdout_len, buffer, length);
+	t->stdout_len += length;
+	if (t->stdout_len == STDOUT_BUFSIZE || memchr(buffer, '\n', length) != NULL) {
+		stdout_flush();
+	}
+}
+
+/* Writes LENGTH bytes from an already validated BUFFER to F,
+   which may be the console or a pipe. */
+static int write_file (struct file *f, const void *buffer, unsigned length) {
+	bool writer;
+	struct pipe *p;
+	int bytesWritten;
+
+	if (f == STDOUT_MARKER) {
+		write_stdout(buffer, length);
+		return length;
+	} else if (f == STDIN_MARKER) {
+		return -1;
+	} else if ((p = file_get_pipe(f, &writer)) != NULL) {
+		return writer ? pipe_write(p, buffer, length) : -1;
+	}
+
+	lock_acquire(&file_lock);
+	bytesWritten = file_write(f, buffer, length);
+	lock_release(&file_lock);
+	return bytesWritten;
 }
 
 int read (int fd, void *buffer, unsigned length) {
@@ -215,38 +372,16 @@ int read (int fd, void *buffer, unsigned length) {
 	//check_address(buffer);
 	validate_buffer(buffer, length, true);
 
-	int bytesRead = 0;
-	if (fd == 0) { 
-		for (int i = 0; i < length; i++) {
-			char c = input_getc();
-			((char *)buffer)[i] = c;
-			bytesRead++;
-
-			if (c == '\n') break;
-		}
-	} else if (fd == 1) {
+	struct file *f = get_file_from_fd_table(fd);
+	if (f == NULL) {
 		return -1;
-	} else {
-		//printf("[syscall read] fd else start\n");
-		struct file *f = get_file_from_fd_table(fd);
-		//printf("[syscall read] f : %p\n", f);
-		if (f == NULL) {
-			//printf("[syscall read] f is NULL!\n");
-			return -1; 
-		}
-		
-		//printf("[syscall read] fd bf lock\n");
-		lock_acquire(&file_lock);
-		bytesRead = file_read(f, buffer, length);
-		lock_release(&file_lock);
-		//printf("[syscall read] fd else end\n");
 	}
-	return bytesRead;
+	return read_file(f, buffer, length);
 }
 
 struct file *get_file_from_fd_table (int fd) {
 	struct thread *t = thread_current();
-	if (fd < 0 || fd >= 128) {
+	if (fd < 0 || fd >= FDCOUNT_LIMIT) {
 		return NULL;
 	}
 	return t->fd_table[fd];
@@ -256,33 +391,204 @@ int write (int fd, const void *buffer, unsigned length) {
 	//check_address(buffer);
 	//printf("[syscall write] fd:%d\n", fd);
 	validate_buffer(buffer, length, false);
-	int bytesRead = 0;
-	//printf("[syscall write] validate_buffer end\n");
 
-	if (fd == 0) {
-		//printf("[syscall write] fd = %d\n", fd);
+	struct file *f = get_file_from_fd_table(fd);
+	if (f == NULL) {
 		return -1;
-	} else if (fd == 1) {
-		putbuf(buffer, length);
-		//printf("[syscall write] bytesRead:%d\n", length);
-		return length;
-	} else {
-		struct file *f = get_file_from_fd_table(fd);
-		if (f == NULL) {
-			//printf("[syscall write] f = %p\n", f);
-			return -1;
+	}
+	return write_file(f, buffer, length);
+}
+
+/* Reads LENGTH bytes from FD at OFFSET without touching the
+   file position, so processes sharing FD after fork() do not
+   race on seek() + read(). */
+int pread (int fd, void *buffer, unsigned length, off_t offset) {
+	validate_buffer(buffer, length, true);
+
+	struct file *f = get_disk_file(fd);
+	if (f == NULL || offset < 0) {
+		return -1;
+	}
+	lock_acquire(&file_lock);
+	int bytesRead = file_read_at(f, buffer, length, offset);
+	lock_release(&file_lock);
+	return bytesRead;
+}
+
+/* Writes LENGTH bytes to FD at OFFSET without touching the file
+   position. */
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset) {
+	validate_buffer(buffer, length, false);
+
+	struct file *f = get_disk_file(fd);
+	if (f == NULL || offset < 0) {
+		return -1;
+	}
+	lock_acquire(&file_lock);
+	int bytesWritten = file_write_at(f, buffer, length, offset);
+	lock_release(&file_lock);
+	return bytesWritten;
+}
+
+/* Copies the IOVCNT-entry user vector UIOV into KIOV and checks
+   every buffer the copy points to, once, before any I/O is done.
+   Only the copy may be used afterward: another thread of the
+   process could rewrite UIOV after the check.  Kills the process
+   on a bad address; returns false if IOVCNT itself is out of
+   range. */
+static bool copy_iovec (struct iovec *kiov, const struct iovec *uiov,
+		int iovcnt, bool is_writable) {
+	if (iovcnt <= 0 || iovcnt > IOV_MAX) {
+		return false;
+	}
+	validate_buffer((void *) uiov, iovcnt * sizeof *uiov, false);
+	memcpy(kiov, uiov, iovcnt * sizeof *kiov);
+	for (int i = 0; i < iovcnt; i++) {
+		if (kiov[i].iov_len > 0) {
+			validate_buffer(kiov[i].iov_base, kiov[i].iov_len, is_writable);
 		}
+	}
+	return true;
+}
+
+/* Scatter read: fills the IOVCNT buffers of IOV in order from FD,
+   as one read() would, and returns the total bytes read. */
+int readv (int fd, const struct iovec *uiov, int iovcnt) {
+	struct iovec iov[IOV_MAX];
+	if (iovcnt == 0) {
+		return 0;
+	}
+	if (!copy_iovec(iov, uiov, iovcnt, true)) {
+		return -1;
+	}
+
+	struct file *f = get_file_from_fd_table(fd);
+	if (f == NULL) {
+		return -1;
+	}
+
+	/* Disk files take file_lock once for the whole vector;
+	   the console and pipes block, so they go one buffer at a time. */
+	bool disk = get_disk_file(fd) != NULL;
+	int bytesRead = 0;
+	if (disk) {
 		lock_acquire(&file_lock);
-		bytesRead = file_write(f, buffer, length);
+	}
+	for (int i = 0; i < iovcnt; i++) {
+		int n = disk ? file_read(f, iov[i].iov_base, iov[i].iov_len)
+			: read_file(f, iov[i].iov_base, iov[i].iov_len);
+		if (n < 0) {
+			bytesRead = bytesRead > 0 ? bytesRead : -1;
+			break;
+		}
+		bytesRead += n;
+		if ((size_t) n < iov[i].iov_len) break;
+	}
+	if (disk) {
 		lock_release(&file_lock);
-		//printf("[syscall write] lock finished\n");
-		
 	}
 	return bytesRead;
 }
 
-void seek (int fd, unsigned position) {
+/* Gather write: writes the IOVCNT buffers of IOV to FD in order,
+   as one write() would, and returns the total bytes written. */
+int writev (int fd, const struct iovec *uiov, int iovcnt) {
+	struct iovec iov[IOV_MAX];
+	if (iovcnt == 0) {
+		return 0;
+	}
+	if (!copy_iovec(iov, uiov, iovcnt, false)) {
+		return -1;
+	}
+
 	struct file *f = get_file_from_fd_table(fd);
+	if (f == NULL) {
+		return -1;
+	}
+
+	bool disk = get_disk_file(fd) != NULL;
+	int bytesWritten = 0;
+	if (disk) {
+		lock_acquire(&file_lock);
+	}
+	for (int i = 0; i < iovcnt; i++) {
+		int n = disk ? file_write(f, iov[i].iov_base, iov[i].iov_len)
+			: write_file(f, iov[i].iov_base, iov[i].iov_len);
+		if (n < 0) {
+			bytesWritten = bytesWritten > 0 ? bytesWritten : -1;
+			break;
+		}
+		bytesWritten += n;
+		if ((size_t) n < iov[i].iov_len) break;
+	}
+	if (disk) {
+		lock_release(&file_lock);
+	}
+	return bytesWritten;
+}
+
+/* Creates a pipe and stores its read end in FDS[0] and its write
+   end in FDS[1].  Returns 0 on success, -1 on failure. */
+int pipe (int *fds) {
+	validate_buffer(fds, 2 * sizeof *fds, true);
+
+	struct pipe *p;
+	if (!pipe_create(&p)) {
+		return -1;
+	}
+	struct file *reader = file_open_pipe(p, false);
+	struct file *writer = file_open_pipe(p, true);
+	if (reader == NULL || writer == NULL) {
+		file_close(reader);
+		file_close(writer);
+		return -1;
+	}
+
+	int rfd = add_file_to_fd_table(reader);
+	int wfd = rfd < 0 ? -1 : add_file_to_fd_table(writer);
+	if (wfd < 0) {
+		if (rfd >= 0) {
+			close(rfd);
+		} else {
+			file_close(reader);
+		}
+		file_close(writer);
+		return -1;
+	}
+	fds[0] = rfd;
+	fds[1] = wfd;
+	return 0;
+}
+
+/* Makes NEWFD refer to the same open file as OLDFD, closing
+   whatever NEWFD referred to first.  Returns NEWFD, or -1 if
+   OLDFD is not open or NEWFD is out of range. */
+int dup2 (int oldfd, int newfd) {
+	struct file *f = get_file_from_fd_table(oldfd);
+	if (f == NULL || newfd < 0 || newfd >= FDCOUNT_LIMIT) {
+		return -1;
+	}
+	if (oldfd == newfd) {
+		return newfd;
+	}
+
+	if (f != STDIN_MARKER && f != STDOUT_MARKER) {
+		file_dup(f);
+	}
+	/* Swap the slot in one step so that no other thread of the
+	   process can claim it in between. */
+	enum intr_level old_level = intr_disable();
+	struct file *old = thread_current()->fd_table[newfd];
+	thread_current()->fd_table[newfd] = f;
+	intr_set_level(old_level);
+	if (old != NULL && old != STDIN_MARKER && old != STDOUT_MARKER) {
+		file_close(old);
+	}
+	return newfd;
+}
+
+void seek (int fd, unsigned position) {
+	struct file *f = get_disk_file(fd);
 	if (f == NULL) {
 		return;
 	}
@@ -290,7 +596,7 @@ void seek (int fd, unsigned position) {
 }
 
 unsigned tell (int fd) {
-	struct file *f = get_file_from_fd_table(fd);
+	struct file *f = get_disk_file(fd);
 	if (f == NULL) {
 		return -1;
 	}
@@ -298,22 +604,145 @@ unsigned tell (int fd) {
 }
 
 void close (int fd) {
-	struct thread *t = thread_current();
+	struct thread *t = thread_current()->leader;
 	struct file **fdt = t->fd_table;
-	if (fd < 0 || fd >= 128) {
-		return;
-	}
-	if (fdt[fd] == NULL) {
+	if (fd < 0 || fd >= FDCOUNT_LIMIT) {
 		return;
 	}
-	file_close(fdt[fd]);
+	enum intr_level old_level = intr_disable();
+	struct file *f = fdt[fd];
 	fdt[fd] = NULL;
+	if (f != NULL && fd < t->fd_idx) {
+		t->fd_idx = fd;
+	}
+	intr_set_level(old_level);
+	if (f != NULL && f != STDIN_MARKER && f != STDOUT_MARKER) {
+		file_close(f);
+	}
+}
+
+/* Registers RING, a region of the caller's own memory, as its
+   submission ring.  Both queues start out empty.  The kernel
+   runs on the process's page table, so it reaches the ring
+   through the same mapping as the program; no copy is kept. */
+int ring_setup (struct ring *ring) {
+	validate_buffer(ring, sizeof *ring, true);
+	ring->sq_head = ring->sq_tail = 0;
+	ring->cq_head = ring->cq_tail = 0;
+	thread_current()->ring = ring;
+	return 0;
+}
+
+/* Runs one submission entry and returns its result. */
+static int ring_run (const struct ring_sqe *sqe) {
+	switch (sqe->op) {
+		case RING_OP_NOP:
+			return 0;
+		case RING_OP_READ:
+			return read(sqe->fd, sqe->buf, sqe->len);
+		case RING_OP_WRITE:
+			return write(sqe->fd, sqe->buf, sqe->len);
+		case RING_OP_SEEK:
+			if (get_disk_file(sqe->fd) == NULL) {
+				return -1;
+			}
+			seek(sqe->fd, sqe->len);
+			return 0;
+		case RING_OP_CLOSE:
+			if (get_file_from_fd_table(sqe->fd) == NULL) {
+				return -1;
+			}
+			close(sqe->fd);
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+/* Runs up to TO_SUBMIT queued entries of the registered ring in
+   order, posting one completion for each.  Stops early when the
+   submission queue is empty or the completion queue is full.
+   Returns the number of entries consumed, or -1 if no ring is
+   registered. */
+int ring_submit (unsigned to_submit) {
+	struct ring *ring = thread_current()->ring;
+	if (ring == NULL) {
+		return -1;
+	}
+	/* The program may have unmapped the ring since setup. */
+	validate_buffer(ring, sizeof *ring, true);
+
+	unsigned done = 0;
+	while (done < to_submit && ring->sq_head != ring->sq_tail
+			&& ring->cq_tail - ring->cq_head < RING_ENTRIES) {
+		/* Copy the entry so the program cannot change it while
+		   it runs. */
+		struct ring_sqe sqe = ring->sq[ring->sq_head % RING_ENTRIES];
+		ring->sq_head++;
+
+		struct ring_cqe *cqe = &ring->cq[ring->cq_tail % RING_ENTRIES];
+		cqe->user_data = sqe.user_data;
+		cqe->res = ring_run(&sqe);
+		ring->cq_tail++;
+		done++;
+	}
+	return done;
+}
+
+/* Waits on or wakes the futex at UADDR, depending on OP; see
+   <futex.h>.  The address must lie in a page the supplemental
+   page table knows about, or the process is killed, and must be
+   aligned to an int, which keeps it within that one page.
+   Returns -1 for a misaligned address or an unknown OP. */
+int futex (int *uaddr, int op, int val) {
+	if ((uintptr_t) uaddr % sizeof *uaddr != 0) {
+		return -1;
+	}
+	check_address(uaddr);
+
+	switch (op) {
+		case FUTEX_WAIT:
+			return futex_wait(uaddr, val);
+		case FUTEX_WAKE:
+			return val > 0 ? futex_wake(uaddr, val) : 0;
+		default:
+			return -1;
+	}
+}
+
+/* Starts a thread in the calling process that runs ENTRY (ARG0,
+   ARG1) on the stack whose top is STACK, sharing the process's
+   memory and open files.  Returns its thread id, or -1 on
+   failure. */
+tid_t uthread_create (void *entry, uint64_t arg0, uint64_t arg1, void *stack) {
+	if (entry == NULL || !is_user_vaddr(entry)
+			|| stack == NULL || !is_user_vaddr(stack)) {
+		return TID_ERROR;
+	}
+	return process_create_thread((uintptr_t) entry, arg0, arg1,
+			(uintptr_t) stack);
+}
+
+/* Waits for thread TID of the calling process to end.  Returns 0
+   once it has, or -1 if TID cannot be joined. */
+int uthread_join (tid_t tid) {
+	return process_join_thread(tid);
+}
+
+/* Ends the calling thread.  The main thread ending ends the
+   process, as if by exit (0). */
+void uthread_exit (void) {
+	struct thread *t = thread_current();
+	if (t->leader == t) {
+		exit(0);
+	}
+	thread_exit();
 }
 
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	//printf("[mmap] addr:%p / length:%d / writable:%d / fd:%d /offset: %d \n", addr, length, writable, fd, offset);
-	struct file* target_file = get_file_from_fd_table(fd);
+	struct file* target_file = get_disk_file(fd);
 
 	// the file descriptors representing console input and output are not mappable
 	if (fd == 0 || fd == 1) {
@@ -360,12 +789,17 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 		//printf("[mmap] fail case 5 \n");
 		return NULL;
 	}
+
+	/* The vDSO page is mapped outside the SPT. */
+	if ((uint64_t) addr <= VDSO_BASE && VDSO_BASE - (uint64_t) addr < length) {
+		return NULL;
+	}
 	
 	/* vm overlapping issues */
 
 	/* if the range of pages mapped overlaps any existing set of mapped pages */ 
 	// overlaps pages mapped at executable load time
-	if(spt_find_page(&thread_current()->spt, addr)) {
+	if(spt_find_page(&thread_current()->leader->spt, addr)) {
 		//printf("[mmap] fail case 7 \n");
 		return NULL;
 	}
@@ -377,7 +811,7 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 		return NULL;
 	}
 
-	struct page* p = spt_find_page(&thread_current()->spt, res);
+	struct page* p = spt_find_page(&thread_current()->leader->spt, res);
 	//printf("[mmap] ending page found : %p\n", p);
 	struct load_info* container = p->uninit.aux;
 	//printf("[mmap] container file addr:%p, addr:%p, container->read_bytes: %d, container->ofs:%d \n", container->file, addr, container->read_bytes, container->ofs);
@@ -432,6 +866,10 @@ syscall_handler (struct intr_frame *f) {
 	thread_current()->intr_rsp = f->rsp;
 	//printf("[syscall checking] curr intr_rsp %p,\n",thread_current()->intr_rsp);
 	#endif
+	/* Another thread has ended the process. */
+	if (thread_current()->leader->exiting) {
+		thread_exit();
+	}
 	switch (f->R.rax) {
 		case SYS_HALT:
 			halt();
@@ -487,8 +925,48 @@ syscall_handler (struct intr_frame *f) {
 			{void* res = f->R.rdi;
 			munmap(f->R.rdi);
 			break;}
+		case SYS_PREAD:
+			f->R.rax = pread(f->R.rdi, (void *) f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+		case SYS_PWRITE:
+			f->R.rax = pwrite(f->R.rdi, (const void *) f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+		case SYS_READV:
+			f->R.rax = readv(f->R.rdi, (const struct iovec *) f->R.rsi, f->R.rdx);
+			break;
+		case SYS_WRITEV:
+			f->R.rax = writev(f->R.rdi, (const struct iovec *) f->R.rsi, f->R.rdx);
+			break;
+		case SYS_PIPE:
+			f->R.rax = pipe((int *) f->R.rdi);
+			break;
+		case SYS_DUP2:
+			f->R.rax = dup2(f->R.rdi, f->R.rsi);
+			break;
+		case SYS_RING_SETUP:
+			f->R.rax = ring_setup((struct ring *) f->R.rdi);
+			break;
+		case SYS_SUBMIT:
+			f->R.rax = ring_submit(f->R.rdi);
+			break;
+		case SYS_FUTEX:
+			f->R.rax = futex((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_THREAD_CREATE:
+			f->R.rax = uthread_create((void *) f->R.rdi, f->R.rsi, f->R.rdx, (void *) f->R.r10);
+			break;
+		case SYS_THREAD_JOIN:
+			f->R.rax = uthread_join(f->R.rdi);
+			break;
+		case SYS_THREAD_EXIT:
+			uthread_exit();
+			break;
 		default:
 			exit(-1);
 	}
+	/* The process may have ended while this call slept. */
+	if (thread_current()->leader->exiting) {
+		thread_exit();
+	}
 	//printf("[syscall] end \n");
 }
@@ -4,3 +4,5 @@ userprog_SRC += userprog/syscall-entry.S # System call entry.
 userprog_SRC += userprog/syscall.c	# System call handler.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
+userprog_SRC += userprog/vdso.c		# Shared read-only page.
+userprog_SRC += userprog/futex.c	# Futex wait queues.
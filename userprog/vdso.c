@@ -0,0 +1,60 @@
+#include "userprog/vdso.h"
+#include <vdso.h>
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+
+/* Gives T, which must already have a page table, its own vDSO
+   page, mapped read-only at VDSO_BASE.  The kernel keeps
+   writing to the page through its kernel address.  Returns true
+   if successful, false on failure. */
+bool
+vdso_map (struct thread *t) {
+	struct vdso_data *vdso;
+
+	ASSERT (t->pml4 != NULL);
+	ASSERT (t->vdso == NULL);
+
+	vdso = palloc_get_page (PAL_USER | PAL_ZERO);
+	if (vdso == NULL)
+		return false;
+	if (!pml4_set_page (t->pml4, (void *) VDSO_BASE, vdso, false)) {
+		palloc_free_page (vdso);
+		return false;
+	}
+
+	vdso->timer_freq = TIMER_FREQ;
+	vdso->tid = t->tid;
+	vdso->ticks = timer_ticks ();
+	t->vdso = vdso;
+	return true;
+}
+
+/* Removes T's vDSO page, if it has one.  Must be called before
+   T's page table is destroyed, which would otherwise free the
+   page behind the timer interrupt's back. */
+void
+vdso_unmap (struct thread *t) {
+	struct vdso_data *vdso = t->vdso;
+
+	if (vdso == NULL)
+		return;
+
+	/* Once this store is done, no timer interrupt will touch the
+	   page again. */
+	t->vdso = NULL;
+	barrier ();
+
+	pml4_clear_page (t->pml4, (void *) VDSO_BASE);
+	palloc_free_page (vdso);
+}
+
+/* Publishes TICKS in T's vDSO page, if it has one.  Called from
+   the timer interrupt for the running thread and on every
+   context switch for the incoming one. */
+void
+vdso_update (struct thread *t, int64_t ticks) {
+	if (t->vdso != NULL)
+		t->vdso->ticks = ticks;
+}
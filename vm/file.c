@@ -138,7 +138,9 @@ do_mmap (void *addr, size_t length, int writable,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* Set up container to pass information to the lazy_load_segment. */
-		struct load_info* container = (struct load_info*)malloc(sizeof(struct load_info));
+		struct load_info* container = kmem_cache_alloc(load_info_cachep);
+		if (container == NULL)
+			return NULL;
 		// insert the given arguments
 		container->file = target_file;
 		container->ofs = offset;
@@ -154,7 +156,7 @@ do_mmap (void *addr, size_t length, int writable,
 				
 				return NULL;}
 		
-		struct page *p = spt_find_page(&thread_current()->spt, start_addr);
+		struct page *p = spt_find_page(&thread_current()->leader->spt, start_addr);
         p->mapped_page_count = total_page_count;
 		
 		/* Advance for moving next page */
@@ -175,7 +177,7 @@ void
 do_munmap (void *addr) {
 
 	while(true) {
-		struct page *p = spt_find_page(&thread_current()->spt, addr);
+		struct page *p = spt_find_page(&thread_current()->leader->spt, addr);
 		if(p==NULL){
 			break;
 		}
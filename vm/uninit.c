@@ -67,7 +67,7 @@ uninit_destroy (struct page *page) {
 	 * TODO: If you don't have anything to do, just return. */
 
 	if(page->uninit.aux != NULL) {
-		free(page->uninit.aux);
+		kmem_cache_free(load_info_cachep, page->uninit.aux);
 	}
 
 	return;
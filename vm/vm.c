@@ -6,11 +6,18 @@
 /* project 3 */
 #include "lib/kernel/hash.h"
 #include "threads/vaddr.h"
+#include "threads/mmu.h"
 #include "userprog/process.h"
 
 /* frame table for frame management*/
 struct list frame_table;
-struct lock frame_table_lock;
+/* Write-locked to change the frame table or the frames in it,
+   including eviction's scan, which clears accessed bits. */
+struct rwlock frame_table_lock;
+
+struct kmem_cache *page_cachep;
+struct kmem_cache *frame_cachep;
+struct kmem_cache *load_info_cachep;
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -24,8 +31,23 @@ vm_init (void) {
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	lock_init(&frame_table_lock);
+	rwlock_init(&frame_table_lock);
 	list_init(&frame_table);
+
+	page_cachep = kmem_cache_create("page", sizeof(struct page), NULL);
+	frame_cachep = kmem_cache_create("frame", sizeof(struct frame), NULL);
+	load_info_cachep = kmem_cache_create("load_info", sizeof(struct load_info), NULL);
+	if (page_cachep == NULL || frame_cachep == NULL || load_info_cachep == NULL) {
+		PANIC("vm_init: out of memory");
+	}
+}
+
+/* Prints statistics for the VM object caches. */
+void
+vm_print_stats (void) {
+	kmem_cache_print_stats (page_cachep);
+	kmem_cache_print_stats (frame_cachep);
+	kmem_cache_print_stats (load_info_cachep);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -48,26 +70,27 @@ static bool vm_do_claim_page (struct page *page);
 static struct frame *vm_evict_frame (void);
 
 /* project 3 : helpers for hash */
-unsigned page_hash (const struct hash_elem *p_, void *aux UNUSED); 
-bool page_less (const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED); 
+uint64_t page_hash (const struct ohash_elem *p_, void *aux UNUSED);
+bool page_less (const struct ohash_elem *a_, const struct ohash_elem *b_, void *aux UNUSED);
 struct page *page_lookup (const void *va, struct supplemental_page_table *spt);
-void page_free(struct hash_elem* e, void* aux);
+void page_free(struct ohash_elem* e, void* aux);
 bool check_stack_boundary(uintptr_t rsp, void* fault_addr);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
- * `vm_alloc_page`. */
+ * `vm_alloc_page`.  AUX, if nonnull, must come from load_info_cachep;
+ * it is freed on failure. */
 bool
 vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		vm_initializer *init, void *aux) {
 
 	ASSERT (VM_TYPE(type) != VM_UNINIT)
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
 	/* Check wheter the upage is already occupied or not. */
 	void* upage_va = upage;
 	if (spt_find_page (spt, upage) == NULL) {
 		/* Create the page, fetch the initialier according to the VM type*/
-		struct page* new_page = malloc(sizeof(struct page));
+		struct page* new_page = kmem_cache_alloc(page_cachep);
 		if(new_page == NULL){
 			goto err;
 		}
@@ -91,14 +114,14 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 		/* TODO: Insert the page into the spt. */
 		if(!spt_insert_page(spt, new_page)) {
-			free(new_page);
-			free(aux);
+			kmem_cache_free(page_cachep, new_page);
 			goto err;
 		}
 
 		return true;
 	}
 err:
+	kmem_cache_free(load_info_cachep, aux);
 	return false;
 }
 
@@ -107,7 +130,9 @@ struct page *
 spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	struct page *page = NULL;
 	/* TODO: Fill this function. */
+	rwlock_acquire_read(&spt->lock);
 	page = page_lookup(va, spt);
+	rwlock_release_read(&spt->lock);
 
 	return page;
 }
@@ -116,65 +141,69 @@ spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 bool
 spt_insert_page (struct supplemental_page_table *spt UNUSED,
 		struct page *page UNUSED) {
-	// hash_insert will return NULL if it is succees to insert new one
-	return hash_insert(&spt->spt_hash, &page->hash_elem) == NULL;
+	// ohash_insert will return NULL if it is succees to insert new one
+	bool success;
+
+	rwlock_acquire_write(&spt->lock);
+	success = ohash_insert(&spt->spt_hash, &page->hash_elem) == NULL;
+	rwlock_release_write(&spt->lock);
+	return success;
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	rwlock_acquire_write(&spt->lock);
+	ohash_delete(&spt->spt_hash, &page->hash_elem);
+	rwlock_release_write(&spt->lock);
 	vm_dealloc_page (page);
 	return true;
 }
-struct list_elem *policy_ref;
-/* Get the struct frame, that will be evicted. */
+/* Get the struct frame, that will be evicted.  Gives each frame
+ * a second chance by clearing its accessed bit on the first pass.
+ * The scan writes accessed bits, and the victim comes off the
+ * frame table before the lock is dropped, so that two faulting
+ * threads never pick the same frame; vm_get_frame() puts it back.
+ * Returns NULL if no frame can be evicted. */
 static struct frame *
 vm_get_victim (void) {
-	
-	struct frame *victim = NULL;
-	//  /* TODO: The policy for eviction is up to you. */
-	/* this policy occurs error in test case: swap-iter! */
 	struct thread *curr = thread_current();
-    policy_ref = list_begin(&frame_table);
-    
-    lock_acquire(&frame_table_lock);
-    for (policy_ref; policy_ref != list_end(&frame_table);
-         policy_ref = list_next(policy_ref)) {
-        victim = list_entry(policy_ref, struct frame, frame_elem);
-        // if bit is 1
-        if (pml4_is_accessed(curr->pml4, victim->page->va)) {
-            pml4_set_accessed(curr->pml4, victim->page->va, 0);
-        } else {
-            lock_release(&frame_table_lock);
-            return victim;
-        }
-    }
-
-    struct list_elem *iter = list_begin(&frame_table);
-
-    for (iter; iter != list_end(&frame_table); iter = list_next(iter)) {
-        victim = list_entry(iter, struct frame, frame_elem);
-        // if bit is 1
-        if (pml4_is_accessed(curr->pml4, victim->page->va)) {
-            pml4_set_accessed(curr->pml4, victim->page->va, 0);
-        } else {
-            lock_release(&frame_table_lock);
-            return victim;
-        }
-    }
-    
-    lock_release(&frame_table_lock);
-    ASSERT(policy_ref != NULL);
-    return victim;
-	
-
+	struct frame *victim = NULL;
+	struct list_elem *e;
+	int pass;
+
+	rwlock_acquire_write(&frame_table_lock);
+	for (pass = 0; pass < 2 && victim == NULL; pass++) {
+		for (e = list_begin(&frame_table); e != list_end(&frame_table);
+				e = list_next(e)) {
+			struct frame *f = list_entry(e, struct frame, frame_elem);
+
+			/* A recycled frame still waiting for its new page. */
+			if (f->page == NULL)
+				continue;
+			if (pml4_is_accessed(curr->pml4, f->page->va)) {
+				pml4_set_accessed(curr->pml4, f->page->va, 0);
+			} else {
+				victim = f;
+				list_remove(e);
+				break;
+			}
+		}
+	}
+	rwlock_release_write(&frame_table_lock);
+	return victim;
 }
+
 /* Evict one page and return the corresponding frame.
  * Return NULL on error.*/
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
-	/* TODO: swap out the victim and return the evicted frame. */
+	struct frame *victim = vm_get_victim ();
+
+	if (victim == NULL)
+		return NULL;
 	swap_out(victim->page);
+	victim->page->frame = NULL;
+	victim->page = NULL;
 	return victim;
 }
 
@@ -186,7 +215,7 @@ vm_evict_frame (void) {
 static struct frame *
 vm_get_frame (void) {
 	/* TODO: Fill this function. */
-	struct frame *frame = calloc(1, sizeof(struct frame));
+	struct frame *frame = kmem_cache_alloc(frame_cachep);
 	if(! frame) {
 		PANIC("[1] todo (vm_get_frame / swap out)");
 		return NULL;
@@ -196,17 +225,19 @@ vm_get_frame (void) {
 	frame->page = NULL;
 
 	if(frame->kva == NULL) {
+		/* Reuse the victim's frame instead. */
+		kmem_cache_free(frame_cachep, frame);
 		frame = vm_evict_frame();
-		frame->page = NULL;
-		return frame;
+		if (frame == NULL)
+			PANIC("out of user frames");
 	}
 
 	ASSERT (frame != NULL);
 	ASSERT (frame->page == NULL);
 
-	lock_acquire(&frame_table_lock);
+	rwlock_acquire_write(&frame_table_lock);
 	list_push_back(&frame_table, &frame->frame_elem);
-	lock_release(&frame_table_lock);
+	rwlock_release_write(&frame_table_lock);
 
 	return frame;
 }
@@ -229,7 +260,7 @@ vm_handle_wp (struct page *page UNUSED) {
 bool
 vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
-	struct supplemental_page_table *spt UNUSED = &thread_current ()->spt;
+	struct supplemental_page_table *spt UNUSED = &thread_current ()->leader->spt;
 	struct page *page = NULL;
 
 	/* TODO: Validate the fault */
@@ -281,7 +312,7 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 void
 vm_dealloc_page (struct page *page) {
 	destroy (page);
-	free (page);
+	kmem_cache_free (page_cachep, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -291,7 +322,7 @@ vm_claim_page (void *va UNUSED) {
 	// (1) get roundown va
 	// (2) get page from spt(va->spt->page)
 	struct thread* curr = thread_current();
-	struct page *page = spt_find_page(&curr->spt, va);
+	struct page *page = spt_find_page(&curr->leader->spt, va);
 
 	if(page==NULL) {
 		return false;
@@ -321,11 +352,43 @@ vm_do_claim_page (struct page *page) {
 	return swap_in (page, frame->kva);
 }
 
+/* Replaces the memory backing the resident, writable anonymous
+ * page at user address VA with KVA, a user pool page owned by the
+ * caller, and returns the page that used to back VA, which the
+ * caller now owns.  This moves a page of data into the process
+ * without copying it.  Returns NULL, changing nothing, if VA is
+ * not such a page. */
+void *
+vm_exchange_frame (void *va, void *kva) {
+	struct thread *curr = thread_current ();
+	struct page *page = spt_find_page (&curr->leader->spt, va);
+	void *old_kva;
+
+	ASSERT (pg_ofs (kva) == 0);
+
+	rwlock_acquire_write (&frame_table_lock);
+	if (page == NULL || page->frame == NULL || !page->writable
+			|| page_get_type (page) != VM_ANON
+			|| pml4_get_page (curr->pml4, page->va) != page->frame->kva) {
+		rwlock_release_write (&frame_table_lock);
+		return NULL;
+	}
+
+	old_kva = page->frame->kva;
+	pml4_clear_page (curr->pml4, page->va);
+	pml4_set_page (curr->pml4, page->va, kva, true);
+	page->frame->kva = kva;
+	rwlock_release_write (&frame_table_lock);
+
+	return old_kva;
+}
+
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
-	struct hash* target_ht = &spt->spt_hash;
-	if(! hash_init(target_ht, page_hash, page_less, NULL)) {
+	struct ohash* target_ht = &spt->spt_hash;
+	rwlock_init(&spt->lock);
+	if(! ohash_init(target_ht, page_hash, page_less, NULL)) {
 		return NULL;
 	}
 
@@ -335,11 +398,14 @@ supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
-			struct hash_iterator i;
-			hash_first (&i, &src->spt_hash);
-			while (hash_next (&i))
+			struct ohash_iterator i;
+			/* DST is the current thread's own table, so filling it
+			 * in takes only DST's lock, never SRC's. */
+			rwlock_acquire_read (&src->lock);
+			ohash_first (&i, &src->spt_hash);
+			while (ohash_next (&i))
 			{
-				struct page* page = hash_entry (hash_cur (&i), struct page, hash_elem);
+				struct page* page = ohash_entry (ohash_cur (&i), struct page, hash_elem);
 				enum vm_type type = VM_TYPE(page->operations->type);
 				void* va = page->va;
 				switch(type) {
@@ -363,14 +429,13 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 					//uninit page
 					case VM_UNINIT:
 						{//aux 
-						void* aux = malloc(sizeof(struct load_info));
+						void* aux = kmem_cache_alloc(load_info_cachep);
 						if(aux == NULL) {
 							goto err;
 						}
 						memcpy(aux, page->uninit.aux,sizeof(struct load_info));
 						//page alloc
 						if(vm_alloc_page_with_initializer(page->uninit.type, va, page->writable, page->uninit.init, aux) == false) {
-							free(aux);
 							goto err;
 						}
 
@@ -387,8 +452,10 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 						memcpy(child_page->frame->kva, page->frame->kva, PGSIZE);
 					}
 				}
+				rwlock_release_read (&src->lock);
 				return true;
 err:
+	rwlock_release_read (&src->lock);
 	return false;
 
 }
@@ -398,26 +465,29 @@ void
 supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread */
 	/* TODO: writeback all the modified contents to the storage. */
-	
-	hash_clear(&spt->spt_hash, page_free);
+
+	/* No lock: writing back a file page reads user memory, and a
+	 * fault there would look the page up in this very table.
+	 * The table itself goes too; process_exec() makes a new one. */
+	ohash_destroy(&spt->spt_hash, page_free);
 
 }
 
 /* project 3 */
 /* hash table functions */
 /* Returns a hash value for page p. */
-unsigned
-page_hash (const struct hash_elem *p_, void *aux UNUSED) {
-  const struct page *p = hash_entry (p_, struct page, hash_elem);
+uint64_t
+page_hash (const struct ohash_elem *p_, void *aux UNUSED) {
+  const struct page *p = ohash_entry (p_, struct page, hash_elem);
   return hash_bytes (&p->va, sizeof p->va);
 }
 
 /* Returns true if page a precedes page b. */
 bool
-page_less (const struct hash_elem *a_,
-           const struct hash_elem *b_, void *aux UNUSED) {
-  const struct page *a = hash_entry (a_, struct page, hash_elem);
-  const struct page *b = hash_entry (b_, struct page, hash_elem);
+page_less (const struct ohash_elem *a_,
+           const struct ohash_elem *b_, void *aux UNUSED) {
+  const struct page *a = ohash_entry (a_, struct page, hash_elem);
+  const struct page *b = ohash_entry (b_, struct page, hash_elem);
 
   return a->va < b->va;
 }
@@ -426,17 +496,17 @@ page_less (const struct hash_elem *a_,
 struct page *
 page_lookup (const void *va, struct supplemental_page_table *spt) {
   struct page p;
-  struct hash_elem *e;
+  struct ohash_elem *e;
 
   p.va = pg_round_down(va);
-  e = hash_find (&spt->spt_hash, &p.hash_elem);
-  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+  e = ohash_find (&spt->spt_hash, &p.hash_elem);
+  return e != NULL ? ohash_entry (e, struct page, hash_elem) : NULL;
 }
 
 /* Free the page containing the given hash elem, or a null pointer if no such page exists. The page will be freed by vm_dealloc_page because the actual page table(pml4) and the physical memory(palloc-ed memory) will be cleaned after SPT is cleaned up.*/
 void
-page_free(struct hash_elem* e, void* aux) {
-	struct page* page = hash_entry(e, struct page, hash_elem);
+page_free(struct ohash_elem* e, void* aux) {
+	struct page* page = ohash_entry(e, struct page, hash_elem);
 	if(page == NULL) {
 		return false;
 	}